@@ -0,0 +1,12 @@
+#version 450 core
+
+layout(location = 0) out vec4 fColor;
+layout(location = 0) in struct {
+    vec2 UV;
+} In;
+
+layout(binding = 1) uniform sampler2D sTexture;
+
+void main() {
+    fColor = texture(sTexture, In.UV.st);
+}
\ No newline at end of file
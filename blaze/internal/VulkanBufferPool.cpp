@@ -0,0 +1,115 @@
+#include "VulkanBufferPool.hpp"
+
+#include <bit>
+#include <algorithm>
+
+VulkanBufferPool::VulkanBufferPool(VmaAllocator allocator, vk::BufferUsageFlags usage, VmaMemoryUsage memoryUsage, vk::DeviceSize blockSize)
+    : _allocator(allocator)
+    , _usage(usage)
+    , _memoryUsage(memoryUsage)
+    , _blockSize(blockSize) {}
+
+VulkanBufferPool::~VulkanBufferPool() {
+    for (const auto& block : _blocks) {
+        _destroyBlock(block);
+    }
+}
+
+// Virtual allocations only take power of two alignments. Other strides, such as 20-byte
+// vertices, over-allocate by a stride and round the offset up inside the range.
+auto VulkanBufferPool::allocate(vk::DeviceSize size, vk::DeviceSize stride, bool grow) -> tl::optional<VulkanBufferRange> {
+    const auto aligned = std::has_single_bit(stride);
+    const auto createInfo = VmaVirtualAllocationCreateInfo{
+        .size = aligned ? size : size + stride - 1,
+        .alignment = aligned ? stride : 1
+    };
+    if (createInfo.size > _blockSize / 2) {
+        return tl::nullopt;
+    }
+
+    auto allocate = [&](const Block& block) -> tl::optional<VulkanBufferRange> {
+        VmaVirtualAllocation allocation;
+        VkDeviceSize offset;
+        if (vmaVirtualAllocate(block.virtualBlock, &createInfo, &allocation, &offset) != VK_SUCCESS) {
+            return tl::nullopt;
+        }
+        offset = (offset + stride - 1) / stride * stride;
+        return VulkanBufferRange{
+            .buffer = block.buffer,
+            .offset = offset,
+            .data = block.data != nullptr ? block.data + offset : nullptr,
+            .block = block.virtualBlock,
+            .allocation = allocation
+        };
+    };
+
+    for (const auto& block : _blocks) {
+        if (auto range = allocate(block)) {
+            return range;
+        }
+    }
+    if (!grow) {
+        return tl::nullopt;
+    }
+    auto block = _createBlock();
+    if (!block) {
+        return tl::nullopt;
+    }
+    return allocate(_blocks.emplace_back(*block));
+}
+
+// Blocks that run empty are released, except the first one.
+void VulkanBufferPool::free(const VulkanBufferRange& range) {
+    vmaVirtualFree(range.block, range.allocation);
+
+    const auto it = std::ranges::find(_blocks, range.block, &Block::virtualBlock);
+    if (it != _blocks.begin() && vmaIsVirtualBlockEmpty(range.block)) {
+        _destroyBlock(*it);
+        _blocks.erase(it);
+    }
+}
+
+auto VulkanBufferPool::_createBlock() -> tl::optional<Block> {
+    const auto bufferCreateInfo = static_cast<VkBufferCreateInfo>(vk::BufferCreateInfo{
+        .size = _blockSize,
+        .usage = _usage
+    });
+
+    const auto mapped = _memoryUsage != VMA_MEMORY_USAGE_GPU_ONLY;
+    auto allocCreateInfo = VmaAllocationCreateInfo{
+        .flags = mapped ? VMA_ALLOCATION_CREATE_MAPPED_BIT : VmaAllocationCreateFlags{},
+        .usage = _memoryUsage,
+        .requiredFlags = mapped ? VkMemoryPropertyFlags{VK_MEMORY_PROPERTY_HOST_COHERENT_BIT} : VkMemoryPropertyFlags{}
+    };
+    if (_memoryUsage == VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE) {
+        allocCreateInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+        allocCreateInfo.requiredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    }
+
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    VmaAllocationInfo allocationInfo;
+    if (vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, &buffer, &allocation, &allocationInfo) != VK_SUCCESS) {
+        return tl::nullopt;
+    }
+
+    const auto virtualBlockCreateInfo = VmaVirtualBlockCreateInfo{
+        .size = _blockSize
+    };
+
+    VmaVirtualBlock virtualBlock;
+    vmaCreateVirtualBlock(&virtualBlockCreateInfo, &virtualBlock);
+
+    return Block{
+        .buffer = buffer,
+        .allocation = allocation,
+        .data = static_cast<std::byte*>(allocationInfo.pMappedData),
+        .virtualBlock = virtualBlock
+    };
+}
+
+void VulkanBufferPool::_destroyBlock(const Block& block) {
+    vmaClearVirtualBlock(block.virtualBlock);
+    vmaDestroyVirtualBlock(block.virtualBlock);
+    vmaDestroyBuffer(_allocator, block.buffer, block.allocation);
+}
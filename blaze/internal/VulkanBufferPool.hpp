@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <vk_mem_alloc.h>
+#include <tl/optional.hpp>
+#include <vulkan/vulkan.hpp>
+
+struct VulkanBufferRange {
+    vk::Buffer buffer{};
+    vk::DeviceSize offset{};
+    std::byte* data{};
+    VmaVirtualBlock block{};
+    VmaVirtualAllocation allocation{};
+};
+
+// Packs buffers of one usage into large VkBuffers, each managed by a VMA virtual block. Ranges
+// start at a multiple of their stride, so vertex and index data can be addressed through the
+// vertexOffset and firstIndex of a draw instead of a bind offset.
+//
+// VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE places the blocks in memory that is both device local and
+// mapped, the Resizable BAR heap.
+struct VulkanBufferPool {
+public:
+    VulkanBufferPool(VmaAllocator allocator, vk::BufferUsageFlags usage, VmaMemoryUsage memoryUsage, vk::DeviceSize blockSize);
+    ~VulkanBufferPool();
+
+    // Returns nullopt for ranges too large to share a block, those get a buffer of their own,
+    // and when no block can be created for them. Without grow only existing blocks are tried.
+    auto allocate(vk::DeviceSize size, vk::DeviceSize stride, bool grow = true) -> tl::optional<VulkanBufferRange>;
+    void free(const VulkanBufferRange& range);
+
+    [[nodiscard]] auto getBlockCount() const -> size_t {
+        return _blocks.size();
+    }
+
+private:
+    struct Block {
+        vk::Buffer buffer;
+        VmaAllocation allocation;
+        std::byte* data;
+        VmaVirtualBlock virtualBlock;
+    };
+
+    auto _createBlock() -> tl::optional<Block>;
+    void _destroyBlock(const Block& block);
+
+    VmaAllocator _allocator;
+    vk::BufferUsageFlags _usage;
+    VmaMemoryUsage _memoryUsage;
+    vk::DeviceSize _blockSize;
+    std::vector<Block> _blocks;
+};
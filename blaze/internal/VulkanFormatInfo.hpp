@@ -0,0 +1,282 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+// Layout of a format as seen by copies. For block-compressed formats size is the size of a
+// block, for everything else blocks are single texels. Combined depth/stencil formats list the
+// size of a texel in the image, buffer copies address one aspect at a time.
+struct VulkanFormatInfo {
+    glm::u32 size;
+    glm::u32 blockWidth;
+    glm::u32 blockHeight;
+    glm::u32 channels;
+    vk::ImageAspectFlags aspect;
+    bool srgb;
+
+    [[nodiscard]] constexpr auto isCompressed() const -> bool {
+        return blockWidth > 1 || blockHeight > 1;
+    }
+    [[nodiscard]] constexpr auto isDepth() const -> bool {
+        return static_cast<bool>(aspect & vk::ImageAspectFlagBits::eDepth);
+    }
+    [[nodiscard]] constexpr auto isStencil() const -> bool {
+        return static_cast<bool>(aspect & vk::ImageAspectFlagBits::eStencil);
+    }
+    [[nodiscard]] constexpr auto isDepthStencil() const -> bool {
+        return isDepth() || isStencil();
+    }
+};
+
+namespace detail {
+    struct VulkanFormatEntry {
+        vk::Format format;
+        VulkanFormatInfo info;
+    };
+
+    constexpr auto Color(glm::u32 size, glm::u32 channels) -> VulkanFormatInfo {
+        return {size, 1, 1, channels, vk::ImageAspectFlagBits::eColor, false};
+    }
+    constexpr auto Srgb(glm::u32 size, glm::u32 channels) -> VulkanFormatInfo {
+        return {size, 1, 1, channels, vk::ImageAspectFlagBits::eColor, true};
+    }
+    constexpr auto Block(glm::u32 size, glm::u32 width, glm::u32 height, glm::u32 channels) -> VulkanFormatInfo {
+        return {size, width, height, channels, vk::ImageAspectFlagBits::eColor, false};
+    }
+    constexpr auto SrgbBlock(glm::u32 size, glm::u32 width, glm::u32 height, glm::u32 channels) -> VulkanFormatInfo {
+        return {size, width, height, channels, vk::ImageAspectFlagBits::eColor, true};
+    }
+    constexpr auto Depth(glm::u32 size, glm::u32 channels) -> VulkanFormatInfo {
+        return {size, 1, 1, channels, vk::ImageAspectFlagBits::eDepth, false};
+    }
+    constexpr auto Stencil(glm::u32 size, glm::u32 channels) -> VulkanFormatInfo {
+        return {size, 1, 1, channels, vk::ImageAspectFlagBits::eStencil, false};
+    }
+    constexpr auto DepthStencil(glm::u32 size, glm::u32 channels) -> VulkanFormatInfo {
+        return {size, 1, 1, channels, vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil, false};
+    }
+
+    // Every core format, in any order.
+    constexpr VulkanFormatEntry kVulkanFormatEntries[] = {
+        { vk::Format::eR4G4UnormPack8,           Color(1, 2) },
+        { vk::Format::eR4G4B4A4UnormPack16,      Color(2, 4) },
+        { vk::Format::eB4G4R4A4UnormPack16,      Color(2, 4) },
+        { vk::Format::eR5G6B5UnormPack16,        Color(2, 3) },
+        { vk::Format::eB5G6R5UnormPack16,        Color(2, 3) },
+        { vk::Format::eR5G5B5A1UnormPack16,      Color(2, 4) },
+        { vk::Format::eB5G5R5A1UnormPack16,      Color(2, 4) },
+        { vk::Format::eA1R5G5B5UnormPack16,      Color(2, 4) },
+        { vk::Format::eR8Unorm,                  Color(1, 1) },
+        { vk::Format::eR8Snorm,                  Color(1, 1) },
+        { vk::Format::eR8Uscaled,                Color(1, 1) },
+        { vk::Format::eR8Sscaled,                Color(1, 1) },
+        { vk::Format::eR8Uint,                   Color(1, 1) },
+        { vk::Format::eR8Sint,                   Color(1, 1) },
+        { vk::Format::eR8Srgb,                   Srgb(1, 1) },
+        { vk::Format::eR8G8Unorm,                Color(2, 2) },
+        { vk::Format::eR8G8Snorm,                Color(2, 2) },
+        { vk::Format::eR8G8Uscaled,              Color(2, 2) },
+        { vk::Format::eR8G8Sscaled,              Color(2, 2) },
+        { vk::Format::eR8G8Uint,                 Color(2, 2) },
+        { vk::Format::eR8G8Sint,                 Color(2, 2) },
+        { vk::Format::eR8G8Srgb,                 Srgb(2, 2) },
+        { vk::Format::eR8G8B8Unorm,              Color(3, 3) },
+        { vk::Format::eR8G8B8Snorm,              Color(3, 3) },
+        { vk::Format::eR8G8B8Uscaled,            Color(3, 3) },
+        { vk::Format::eR8G8B8Sscaled,            Color(3, 3) },
+        { vk::Format::eR8G8B8Uint,               Color(3, 3) },
+        { vk::Format::eR8G8B8Sint,               Color(3, 3) },
+        { vk::Format::eR8G8B8Srgb,               Srgb(3, 3) },
+        { vk::Format::eB8G8R8Unorm,              Color(3, 3) },
+        { vk::Format::eB8G8R8Snorm,              Color(3, 3) },
+        { vk::Format::eB8G8R8Uscaled,            Color(3, 3) },
+        { vk::Format::eB8G8R8Sscaled,            Color(3, 3) },
+        { vk::Format::eB8G8R8Uint,               Color(3, 3) },
+        { vk::Format::eB8G8R8Sint,               Color(3, 3) },
+        { vk::Format::eB8G8R8Srgb,               Srgb(3, 3) },
+        { vk::Format::eR8G8B8A8Unorm,            Color(4, 4) },
+        { vk::Format::eR8G8B8A8Snorm,            Color(4, 4) },
+        { vk::Format::eR8G8B8A8Uscaled,          Color(4, 4) },
+        { vk::Format::eR8G8B8A8Sscaled,          Color(4, 4) },
+        { vk::Format::eR8G8B8A8Uint,             Color(4, 4) },
+        { vk::Format::eR8G8B8A8Sint,             Color(4, 4) },
+        { vk::Format::eR8G8B8A8Srgb,             Srgb(4, 4) },
+        { vk::Format::eB8G8R8A8Unorm,            Color(4, 4) },
+        { vk::Format::eB8G8R8A8Snorm,            Color(4, 4) },
+        { vk::Format::eB8G8R8A8Uscaled,          Color(4, 4) },
+        { vk::Format::eB8G8R8A8Sscaled,          Color(4, 4) },
+        { vk::Format::eB8G8R8A8Uint,             Color(4, 4) },
+        { vk::Format::eB8G8R8A8Sint,             Color(4, 4) },
+        { vk::Format::eB8G8R8A8Srgb,             Srgb(4, 4) },
+        { vk::Format::eA8B8G8R8UnormPack32,      Color(4, 4) },
+        { vk::Format::eA8B8G8R8SnormPack32,      Color(4, 4) },
+        { vk::Format::eA8B8G8R8UscaledPack32,    Color(4, 4) },
+        { vk::Format::eA8B8G8R8SscaledPack32,    Color(4, 4) },
+        { vk::Format::eA8B8G8R8UintPack32,       Color(4, 4) },
+        { vk::Format::eA8B8G8R8SintPack32,       Color(4, 4) },
+        { vk::Format::eA8B8G8R8SrgbPack32,       Srgb(4, 4) },
+        { vk::Format::eA2R10G10B10UnormPack32,   Color(4, 4) },
+        { vk::Format::eA2R10G10B10SnormPack32,   Color(4, 4) },
+        { vk::Format::eA2R10G10B10UscaledPack32, Color(4, 4) },
+        { vk::Format::eA2R10G10B10SscaledPack32, Color(4, 4) },
+        { vk::Format::eA2R10G10B10UintPack32,    Color(4, 4) },
+        { vk::Format::eA2R10G10B10SintPack32,    Color(4, 4) },
+        { vk::Format::eA2B10G10R10UnormPack32,   Color(4, 4) },
+        { vk::Format::eA2B10G10R10SnormPack32,   Color(4, 4) },
+        { vk::Format::eA2B10G10R10UscaledPack32, Color(4, 4) },
+        { vk::Format::eA2B10G10R10SscaledPack32, Color(4, 4) },
+        { vk::Format::eA2B10G10R10UintPack32,    Color(4, 4) },
+        { vk::Format::eA2B10G10R10SintPack32,    Color(4, 4) },
+        { vk::Format::eR16Unorm,                 Color(2, 1) },
+        { vk::Format::eR16Snorm,                 Color(2, 1) },
+        { vk::Format::eR16Uscaled,               Color(2, 1) },
+        { vk::Format::eR16Sscaled,               Color(2, 1) },
+        { vk::Format::eR16Uint,                  Color(2, 1) },
+        { vk::Format::eR16Sint,                  Color(2, 1) },
+        { vk::Format::eR16Sfloat,                Color(2, 1) },
+        { vk::Format::eR16G16Unorm,              Color(4, 2) },
+        { vk::Format::eR16G16Snorm,              Color(4, 2) },
+        { vk::Format::eR16G16Uscaled,            Color(4, 2) },
+        { vk::Format::eR16G16Sscaled,            Color(4, 2) },
+        { vk::Format::eR16G16Uint,               Color(4, 2) },
+        { vk::Format::eR16G16Sint,               Color(4, 2) },
+        { vk::Format::eR16G16Sfloat,             Color(4, 2) },
+        { vk::Format::eR16G16B16Unorm,           Color(6, 3) },
+        { vk::Format::eR16G16B16Snorm,           Color(6, 3) },
+        { vk::Format::eR16G16B16Uscaled,         Color(6, 3) },
+        { vk::Format::eR16G16B16Sscaled,         Color(6, 3) },
+        { vk::Format::eR16G16B16Uint,            Color(6, 3) },
+        { vk::Format::eR16G16B16Sint,            Color(6, 3) },
+        { vk::Format::eR16G16B16Sfloat,          Color(6, 3) },
+        { vk::Format::eR16G16B16A16Unorm,        Color(8, 4) },
+        { vk::Format::eR16G16B16A16Snorm,        Color(8, 4) },
+        { vk::Format::eR16G16B16A16Uscaled,      Color(8, 4) },
+        { vk::Format::eR16G16B16A16Sscaled,      Color(8, 4) },
+        { vk::Format::eR16G16B16A16Uint,         Color(8, 4) },
+        { vk::Format::eR16G16B16A16Sint,         Color(8, 4) },
+        { vk::Format::eR16G16B16A16Sfloat,       Color(8, 4) },
+        { vk::Format::eR32Uint,                  Color(4, 1) },
+        { vk::Format::eR32Sint,                  Color(4, 1) },
+        { vk::Format::eR32Sfloat,                Color(4, 1) },
+        { vk::Format::eR32G32Uint,               Color(8, 2) },
+        { vk::Format::eR32G32Sint,               Color(8, 2) },
+        { vk::Format::eR32G32Sfloat,             Color(8, 2) },
+        { vk::Format::eR32G32B32Uint,            Color(12, 3) },
+        { vk::Format::eR32G32B32Sint,            Color(12, 3) },
+        { vk::Format::eR32G32B32Sfloat,          Color(12, 3) },
+        { vk::Format::eR32G32B32A32Uint,         Color(16, 4) },
+        { vk::Format::eR32G32B32A32Sint,         Color(16, 4) },
+        { vk::Format::eR32G32B32A32Sfloat,       Color(16, 4) },
+        { vk::Format::eR64Uint,                  Color(8, 1) },
+        { vk::Format::eR64Sint,                  Color(8, 1) },
+        { vk::Format::eR64Sfloat,                Color(8, 1) },
+        { vk::Format::eR64G64Uint,               Color(16, 2) },
+        { vk::Format::eR64G64Sint,               Color(16, 2) },
+        { vk::Format::eR64G64Sfloat,             Color(16, 2) },
+        { vk::Format::eR64G64B64Uint,            Color(24, 3) },
+        { vk::Format::eR64G64B64Sint,            Color(24, 3) },
+        { vk::Format::eR64G64B64Sfloat,          Color(24, 3) },
+        { vk::Format::eR64G64B64A64Uint,         Color(32, 4) },
+        { vk::Format::eR64G64B64A64Sint,         Color(32, 4) },
+        { vk::Format::eR64G64B64A64Sfloat,       Color(32, 4) },
+        { vk::Format::eB10G11R11UfloatPack32,    Color(4, 3) },
+        { vk::Format::eE5B9G9R9UfloatPack32,     Color(4, 3) },
+        { vk::Format::eD16Unorm,                 Depth(2, 1) },
+        { vk::Format::eX8D24UnormPack32,         Depth(4, 1) },
+        { vk::Format::eD32Sfloat,                Depth(4, 1) },
+        { vk::Format::eS8Uint,                   Stencil(1, 1) },
+        { vk::Format::eD16UnormS8Uint,           DepthStencil(3, 2) },
+        { vk::Format::eD24UnormS8Uint,           DepthStencil(4, 2) },
+        { vk::Format::eD32SfloatS8Uint,          DepthStencil(5, 2) },
+        { vk::Format::eBc1RgbUnormBlock,         Block(8, 4, 4, 3) },
+        { vk::Format::eBc1RgbSrgbBlock,          SrgbBlock(8, 4, 4, 3) },
+        { vk::Format::eBc1RgbaUnormBlock,        Block(8, 4, 4, 4) },
+        { vk::Format::eBc1RgbaSrgbBlock,         SrgbBlock(8, 4, 4, 4) },
+        { vk::Format::eBc2UnormBlock,            Block(16, 4, 4, 4) },
+        { vk::Format::eBc2SrgbBlock,             SrgbBlock(16, 4, 4, 4) },
+        { vk::Format::eBc3UnormBlock,            Block(16, 4, 4, 4) },
+        { vk::Format::eBc3SrgbBlock,             SrgbBlock(16, 4, 4, 4) },
+        { vk::Format::eBc4UnormBlock,            Block(8, 4, 4, 1) },
+        { vk::Format::eBc4SnormBlock,            Block(8, 4, 4, 1) },
+        { vk::Format::eBc5UnormBlock,            Block(16, 4, 4, 2) },
+        { vk::Format::eBc5SnormBlock,            Block(16, 4, 4, 2) },
+        { vk::Format::eBc6HUfloatBlock,          Block(16, 4, 4, 3) },
+        { vk::Format::eBc6HSfloatBlock,          Block(16, 4, 4, 3) },
+        { vk::Format::eBc7UnormBlock,            Block(16, 4, 4, 4) },
+        { vk::Format::eBc7SrgbBlock,             SrgbBlock(16, 4, 4, 4) },
+        { vk::Format::eEtc2R8G8B8UnormBlock,     Block(8, 4, 4, 3) },
+        { vk::Format::eEtc2R8G8B8SrgbBlock,      SrgbBlock(8, 4, 4, 3) },
+        { vk::Format::eEtc2R8G8B8A1UnormBlock,   Block(8, 4, 4, 4) },
+        { vk::Format::eEtc2R8G8B8A1SrgbBlock,    SrgbBlock(8, 4, 4, 4) },
+        { vk::Format::eEtc2R8G8B8A8UnormBlock,   Block(16, 4, 4, 4) },
+        { vk::Format::eEtc2R8G8B8A8SrgbBlock,    SrgbBlock(16, 4, 4, 4) },
+        { vk::Format::eEacR11UnormBlock,         Block(8, 4, 4, 1) },
+        { vk::Format::eEacR11SnormBlock,         Block(8, 4, 4, 1) },
+        { vk::Format::eEacR11G11UnormBlock,      Block(16, 4, 4, 2) },
+        { vk::Format::eEacR11G11SnormBlock,      Block(16, 4, 4, 2) },
+        { vk::Format::eAstc4x4UnormBlock,        Block(16, 4, 4, 4) },
+        { vk::Format::eAstc4x4SrgbBlock,         SrgbBlock(16, 4, 4, 4) },
+        { vk::Format::eAstc5x4UnormBlock,        Block(16, 5, 4, 4) },
+        { vk::Format::eAstc5x4SrgbBlock,         SrgbBlock(16, 5, 4, 4) },
+        { vk::Format::eAstc5x5UnormBlock,        Block(16, 5, 5, 4) },
+        { vk::Format::eAstc5x5SrgbBlock,         SrgbBlock(16, 5, 5, 4) },
+        { vk::Format::eAstc6x5UnormBlock,        Block(16, 6, 5, 4) },
+        { vk::Format::eAstc6x5SrgbBlock,         SrgbBlock(16, 6, 5, 4) },
+        { vk::Format::eAstc6x6UnormBlock,        Block(16, 6, 6, 4) },
+        { vk::Format::eAstc6x6SrgbBlock,         SrgbBlock(16, 6, 6, 4) },
+        { vk::Format::eAstc8x5UnormBlock,        Block(16, 8, 5, 4) },
+        { vk::Format::eAstc8x5SrgbBlock,         SrgbBlock(16, 8, 5, 4) },
+        { vk::Format::eAstc8x6UnormBlock,        Block(16, 8, 6, 4) },
+        { vk::Format::eAstc8x6SrgbBlock,         SrgbBlock(16, 8, 6, 4) },
+        { vk::Format::eAstc8x8UnormBlock,        Block(16, 8, 8, 4) },
+        { vk::Format::eAstc8x8SrgbBlock,         SrgbBlock(16, 8, 8, 4) },
+        { vk::Format::eAstc10x5UnormBlock,       Block(16, 10, 5, 4) },
+        { vk::Format::eAstc10x5SrgbBlock,        SrgbBlock(16, 10, 5, 4) },
+        { vk::Format::eAstc10x6UnormBlock,       Block(16, 10, 6, 4) },
+        { vk::Format::eAstc10x6SrgbBlock,        SrgbBlock(16, 10, 6, 4) },
+        { vk::Format::eAstc10x8UnormBlock,       Block(16, 10, 8, 4) },
+        { vk::Format::eAstc10x8SrgbBlock,        SrgbBlock(16, 10, 8, 4) },
+        { vk::Format::eAstc10x10UnormBlock,      Block(16, 10, 10, 4) },
+        { vk::Format::eAstc10x10SrgbBlock,       SrgbBlock(16, 10, 10, 4) },
+        { vk::Format::eAstc12x10UnormBlock,      Block(16, 12, 10, 4) },
+        { vk::Format::eAstc12x10SrgbBlock,       SrgbBlock(16, 12, 10, 4) },
+        { vk::Format::eAstc12x12UnormBlock,      Block(16, 12, 12, 4) },
+        { vk::Format::eAstc12x12SrgbBlock,       SrgbBlock(16, 12, 12, 4) },
+    };
+
+    // Indexed by the enum value, the core formats are numbered contiguously from 0.
+    constexpr auto kVulkanFormatInfos = [] {
+        auto infos = std::array<VulkanFormatInfo, VK_FORMAT_ASTC_12x12_SRGB_BLOCK + 1>{};
+        infos.fill(Color(0, 0));
+        for (const auto& entry : kVulkanFormatEntries) {
+            infos[static_cast<size_t>(entry.format)] = entry.info;
+        }
+        return infos;
+    }();
+
+    constexpr auto HasEveryFormat() -> bool {
+        for (size_t i = 1; i < kVulkanFormatInfos.size(); ++i) {
+            if (kVulkanFormatInfos[i].size == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(HasEveryFormat());
+}
+
+// Formats from extensions and eUndefined come back as color formats with a size of 0.
+constexpr auto GetFormatInfo(vk::Format format) -> const VulkanFormatInfo& {
+    const auto index = static_cast<size_t>(format);
+    return index < detail::kVulkanFormatInfos.size() ? detail::kVulkanFormatInfos[index] : detail::kVulkanFormatInfos[0];
+}
+
+// Bytes of a tightly packed level, partial blocks at the edges count as whole ones.
+constexpr auto GetLevelSize(vk::Format format, glm::uvec2 extent) -> vk::DeviceSize {
+    const auto& info = GetFormatInfo(format);
+    const auto blocksX = (extent.x + info.blockWidth - 1) / info.blockWidth;
+    const auto blocksY = (extent.y + info.blockHeight - 1) / info.blockHeight;
+    return static_cast<vk::DeviceSize>(blocksX) * blocksY * info.size;
+}
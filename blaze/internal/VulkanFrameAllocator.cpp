@@ -0,0 +1,83 @@
+#include "VulkanFrameAllocator.hpp"
+
+#include <algorithm>
+
+VulkanFrameAllocator::VulkanFrameAllocator(VmaAllocator allocator, uint32_t frameCount, vk::DeviceSize capacity)
+    : _allocator(allocator)
+    , _frames(frameCount) {
+    for (auto& frame : _frames) {
+        frame.pages.emplace_back(_createPage(capacity));
+    }
+}
+
+VulkanFrameAllocator::~VulkanFrameAllocator() {
+    for (const auto& frame : _frames) {
+        for (const auto& page : frame.pages) {
+            _destroyPage(page);
+        }
+    }
+}
+
+void VulkanFrameAllocator::beginFrame(uint32_t frameIndex) {
+    _frameIndex = frameIndex;
+
+    auto& frame = _frames[_frameIndex];
+    if (frame.pages.size() > 1) {
+        auto size = vk::DeviceSize{};
+        for (const auto& page : frame.pages) {
+            size += page.size;
+            _destroyPage(page);
+        }
+        frame.pages.clear();
+        frame.pages.emplace_back(_createPage(size));
+    }
+    frame.head = 0;
+}
+
+// Allocations are taken from the last page only, the space left in earlier pages is given up.
+auto VulkanFrameAllocator::allocate(vk::DeviceSize size, vk::DeviceSize alignment) -> VulkanFrameAllocation {
+    auto& frame = _frames[_frameIndex];
+
+    auto offset = (frame.head + alignment - 1) / alignment * alignment;
+    if (offset + size > frame.pages.back().size) {
+        frame.pages.emplace_back(_createPage(std::max(frame.pages.back().size * 2, size)));
+        offset = 0;
+    }
+    frame.head = offset + size;
+
+    const auto& page = frame.pages.back();
+    return VulkanFrameAllocation{
+        .buffer = page.buffer,
+        .offset = offset,
+        .data = page.data + offset
+    };
+}
+
+auto VulkanFrameAllocator::_createPage(vk::DeviceSize size) -> Page {
+    const auto bufferCreateInfo = static_cast<VkBufferCreateInfo>(vk::BufferCreateInfo{
+        .size = size,
+        .usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eUniformBuffer
+    });
+
+    const auto allocCreateInfo = VmaAllocationCreateInfo{
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        .requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    };
+
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    VmaAllocationInfo allocationInfo;
+    vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, &buffer, &allocation, &allocationInfo);
+
+    return Page{
+        .buffer = buffer,
+        .allocation = allocation,
+        .data = static_cast<std::byte*>(allocationInfo.pMappedData),
+        .size = size
+    };
+}
+
+void VulkanFrameAllocator::_destroyPage(const Page& page) {
+    vmaDestroyBuffer(_allocator, page.buffer, page.allocation);
+}
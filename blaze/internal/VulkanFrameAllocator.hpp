@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+
+struct VulkanFrameAllocation {
+    vk::Buffer buffer{};
+    vk::DeviceSize offset{};
+    std::byte* data{};
+};
+
+// Transient memory for data written once per frame, such as dynamic vertices and per-draw
+// constants. Every frame in flight owns a persistently mapped buffer that is handed out with a
+// bump pointer and reset once the frame's last submission has completed.
+//
+// A frame that runs out chains another buffer of twice the size. The next time the frame comes
+// around its buffers are replaced by one that holds everything, so a steady workload settles
+// on no buffer creations at all.
+struct VulkanFrameAllocator {
+public:
+    VulkanFrameAllocator(VmaAllocator allocator, uint32_t frameCount, vk::DeviceSize capacity);
+    ~VulkanFrameAllocator();
+
+    // The caller has waited for the last submission of the frame.
+    void beginFrame(uint32_t frameIndex);
+    auto allocate(vk::DeviceSize size, vk::DeviceSize alignment) -> VulkanFrameAllocation;
+
+    [[nodiscard]] auto getFrameIndex() const -> uint32_t {
+        return _frameIndex;
+    }
+
+private:
+    struct Page {
+        vk::Buffer buffer;
+        VmaAllocation allocation;
+        std::byte* data;
+        vk::DeviceSize size;
+    };
+
+    struct Frame {
+        std::vector<Page> pages;
+        vk::DeviceSize head = 0;
+    };
+
+    auto _createPage(vk::DeviceSize size) -> Page;
+    void _destroyPage(const Page& page);
+
+    VmaAllocator _allocator;
+    std::vector<Frame> _frames;
+    uint32_t _frameIndex = 0;
+};
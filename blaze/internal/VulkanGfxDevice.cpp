@@ -1,6 +1,12 @@
 #include "VulkanTexture.hpp"
 #include "VulkanMaterial.hpp"
 #include "VulkanGfxDevice.hpp"
+#include "VulkanStagingRing.hpp"
+#include "VulkanFormatInfo.hpp"
+#include "VulkanFrameAllocator.hpp"
+#include "VulkanUniformRing.hpp"
+#include "VulkanTimeline.hpp"
+#include "VulkanSamplerCache.hpp"
 #include "VulkanCommandBuffer.hpp"
 #include "VulkanGraphicsBuffer.hpp"
 #include "Resource.hpp"
@@ -14,6 +20,12 @@
 #include <spirv_glsl.hpp>
 #include <spdlog/spdlog.h>
 
+#include <span>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+
 template <>
 auto Json::Into<vk::ShaderStageFlagBits>::into(const Json& o) -> Result {
     return o.as_string().and_then([](auto&& s) -> Result {
@@ -626,10 +638,35 @@ static auto FindQueueFamilies(vk::PhysicalDevice device, vk::SurfaceKHR surface)
     return std::nullopt;
 }
 
-static constexpr auto GetBufferUsageFromTarget(GraphicsBuffer::Target target) -> vk::BufferUsageFlags {
+// Prefers a family that can only transfer, which on discrete GPUs maps to the copy engines, then
+// any non-graphics family with transfer support. Falls back to the graphics family.
+static auto FindTransferFamily(vk::PhysicalDevice device, uint32_t graphicsFamily) -> uint32_t {
+    const auto properties = device.getQueueFamilyProperties();
+
+    auto family = graphicsFamily;
+    for (uint32_t i = 0; i < uint32_t(properties.size()); i++) {
+        const auto flags = properties[i].queueFlags;
+        if (!(flags & vk::QueueFlagBits::eTransfer) || (flags & vk::QueueFlagBits::eGraphics)) {
+            continue;
+        }
+        if (!(flags & vk::QueueFlagBits::eCompute)) {
+            return i;
+        }
+        if (family == graphicsFamily) {
+            family = i;
+        }
+    }
+    return family;
+}
+
+static constexpr auto GetBufferUsageFromTarget(GraphicsBuffer::Target target, GraphicsBuffer::Usage usage) -> vk::BufferUsageFlags {
     using Type = std::underlying_type_t<GraphicsBuffer::Target>;
 
+    // Static buffers are also a copy source, defragmentation moves them with a copy.
     auto flags = vk::BufferUsageFlags{};
+    if (usage == GraphicsBuffer::Usage::Static) {
+        flags |= vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
+    }
     if (static_cast<Type>(target) & static_cast<Type>(GraphicsBuffer::Target::Vertex)) {
         flags |= vk::BufferUsageFlagBits::eVertexBuffer;
     }
@@ -648,9 +685,13 @@ static constexpr auto GetBufferUsageFromTarget(GraphicsBuffer::Target target) ->
     return flags;
 }
 
-static constexpr auto GetMemoryUsageFromTarget(GraphicsBuffer::Target target) -> VmaMemoryUsage {
+static constexpr auto GetMemoryUsageFromTarget(GraphicsBuffer::Target target, GraphicsBuffer::Usage usage) -> VmaMemoryUsage {
     using Type = std::underlying_type_t<GraphicsBuffer::Target>;
 
+    if (usage == GraphicsBuffer::Usage::Static) {
+        return VMA_MEMORY_USAGE_GPU_ONLY;
+    }
+
     auto flags = VMA_MEMORY_USAGE_CPU_TO_GPU;
     if (static_cast<Type>(target) & static_cast<Type>(GraphicsBuffer::Target::CopySrc)) {
         flags = VMA_MEMORY_USAGE_CPU_ONLY;
@@ -661,51 +702,62 @@ static constexpr auto GetMemoryUsageFromTarget(GraphicsBuffer::Target target) ->
     return flags;
 }
 
-static constexpr auto IsDepthFormat(vk::Format format) -> bool {
-    switch (format) {
-        case vk::Format::eD16Unorm:
-        case vk::Format::eX8D24UnormPack32:
-        case vk::Format::eD32Sfloat:
-        case vk::Format::eS8Uint:
-        case vk::Format::eD16UnormS8Uint:
-        case vk::Format::eD24UnormS8Uint:
-        case vk::Format::eD32SfloatS8Uint:
-            return true;
-        default:
-            return false;
+// Targets are used one at a time, the first that matches decides.
+static constexpr auto GetMemoryCategoryFromTarget(GraphicsBuffer::Target target) -> MemoryCategory {
+    using Type = std::underlying_type_t<GraphicsBuffer::Target>;
+
+    if (static_cast<Type>(target) & static_cast<Type>(GraphicsBuffer::Target::Vertex)) {
+        return MemoryCategory::VertexBuffer;
     }
+    if (static_cast<Type>(target) & static_cast<Type>(GraphicsBuffer::Target::Index)) {
+        return MemoryCategory::IndexBuffer;
+    }
+    if (static_cast<Type>(target) & static_cast<Type>(GraphicsBuffer::Target::Constant)) {
+        return MemoryCategory::ConstantBuffer;
+    }
+    return MemoryCategory::TransferBuffer;
+}
+
+// The stages and accesses that read a buffer with the given usage.
+static constexpr auto GetBufferReadStages(vk::BufferUsageFlags usage) -> vk::PipelineStageFlags {
+    auto stages = vk::PipelineStageFlags{};
+    if (usage & (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer)) {
+        stages |= vk::PipelineStageFlagBits::eVertexInput;
+    }
+    if (usage & vk::BufferUsageFlagBits::eUniformBuffer) {
+        stages |= vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+    }
+    return stages;
+}
+
+static constexpr auto GetBufferReadAccess(vk::BufferUsageFlags usage) -> vk::AccessFlags {
+    auto access = vk::AccessFlags{};
+    if (usage & vk::BufferUsageFlagBits::eVertexBuffer) {
+        access |= vk::AccessFlagBits::eVertexAttributeRead;
+    }
+    if (usage & vk::BufferUsageFlagBits::eIndexBuffer) {
+        access |= vk::AccessFlagBits::eIndexRead;
+    }
+    if (usage & vk::BufferUsageFlagBits::eUniformBuffer) {
+        access |= vk::AccessFlagBits::eUniformRead;
+    }
+    return access;
+}
+
+static constexpr auto IsDepthFormat(vk::Format format) -> bool {
+    return GetFormatInfo(format).isDepthStencil();
 }
 
 static constexpr auto GetImageUsageFromFormat(vk::Format format) -> vk::ImageUsageFlags {
-    switch (format) {
-        case vk::Format::eD16Unorm:
-        case vk::Format::eX8D24UnormPack32:
-        case vk::Format::eD32Sfloat:
-        case vk::Format::eS8Uint:
-        case vk::Format::eD16UnormS8Uint:
-        case vk::Format::eD24UnormS8Uint:
-        case vk::Format::eD32SfloatS8Uint:
-            return vk::ImageUsageFlagBits::eDepthStencilAttachment;
-        default:
-            return vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+    if (IsDepthFormat(format)) {
+        return vk::ImageUsageFlagBits::eDepthStencilAttachment;
     }
+    // Mip chains blit from the levels above, defragmentation copies the whole image.
+    return vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc;
 }
 
 static constexpr auto GetImageAspectFromFormat(vk::Format format) -> vk::ImageAspectFlags {
-    switch (format) {
-        case vk::Format::eD16Unorm:
-        case vk::Format::eX8D24UnormPack32:
-        case vk::Format::eD32Sfloat:
-            return vk::ImageAspectFlagBits::eDepth;
-        case vk::Format::eS8Uint:
-            return vk::ImageAspectFlagBits::eStencil;
-        case vk::Format::eD16UnormS8Uint:
-        case vk::Format::eD24UnormS8Uint:
-        case vk::Format::eD32SfloatS8Uint:
-            return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
-        default:
-            return vk::ImageAspectFlagBits::eColor;
-    }
+    return GetFormatInfo(format).aspect;
 }
 
 VulkanGfxDevice::VulkanGfxDevice(Display& display) {
@@ -714,9 +766,25 @@ VulkanGfxDevice::VulkanGfxDevice(Display& display) {
     _selectPhysicalDevice();
     _createLogicalDevice();
     _createMemoryResource();
+    _createTimelines();
+    _createStagingRing();
+    _createSamplerCache();
 }
 
 VulkanGfxDevice::~VulkanGfxDevice() {
+    WaitIdle();
+    _collectDestructions(true);
+    if (_defragmentation != nullptr) {
+        _endDefragmentation();
+    }
+
+    _frameAllocator.reset();
+    _uniformRing.reset();
+    _bufferPools.clear();
+    _stagingRing.reset();
+    _transferTimeline.reset();
+    _graphicsTimeline.reset();
+    _samplerCache.reset();
     vmaDestroyAllocator(_allocator);
     _logicalDevice.destroy();
     _instance.destroySurfaceKHR(_surface);
@@ -794,6 +862,7 @@ void VulkanGfxDevice::_selectPhysicalDevice() {
         _physicalDevice = device;
         _graphicsFamily = families->first;
         _presentFamily = families->second;
+        _transferFamily = FindTransferFamily(device, _graphicsFamily);
         return;
     }
 }
@@ -820,7 +889,17 @@ void VulkanGfxDevice::_createLogicalDevice() {
         queueCreateInfos.emplace_back(presentQueueCreateInfo);
     }
 
-    static constexpr auto deviceExtensions = std::array{
+    if (_transferFamily != _graphicsFamily && _transferFamily != _presentFamily) {
+        const auto transferQueueCreateInfo = vk::DeviceQueueCreateInfo {
+            .queueFamilyIndex = _transferFamily,
+            .queueCount = 1,
+            .pQueuePriorities = &queuePriority
+        };
+
+        queueCreateInfos.emplace_back(transferQueueCreateInfo);
+    }
+
+    auto deviceExtensions = std::vector<const char*>{
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         VK_KHR_BIND_MEMORY_2_EXTENSION_NAME,
         VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME,
@@ -831,9 +910,22 @@ void VulkanGfxDevice::_createLogicalDevice() {
 //        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
     };
 
+    // Real budgets from the driver instead of VMA's estimate from its own allocations.
+    const auto availableExtensions = _physicalDevice.enumerateDeviceExtensionProperties();
+    _hasMemoryBudget = std::ranges::any_of(availableExtensions, [](const vk::ExtensionProperties& properties) {
+        return std::strcmp(properties.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+    });
+    if (_hasMemoryBudget) {
+        deviceExtensions.emplace_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    // Block-compressed textures need BC sampling, which desktop GPUs generally have.
+    const auto supported = _physicalDevice.getFeatures();
+    _hasTextureCompressionBC = supported.textureCompressionBC == VK_TRUE;
     const auto features = vk::PhysicalDeviceFeatures{
         .fillModeNonSolid = VK_TRUE,
-        .samplerAnisotropy = VK_TRUE
+        .samplerAnisotropy = VK_TRUE,
+        .textureCompressionBC = supported.textureCompressionBC
     };
 
 //        auto dynamicRenderingFeaturesKHR = vk::PhysicalDeviceDynamicRenderingFeaturesKHR{
@@ -845,13 +937,18 @@ void VulkanGfxDevice::_createLogicalDevice() {
 //            .features = features
 //        };
 
+    const auto timelineSemaphoreFeatures = vk::PhysicalDeviceTimelineSemaphoreFeatures{
+        .timelineSemaphore = VK_TRUE
+    };
+
     const auto deviceCreateInfo = vk::DeviceCreateInfo {
 //            .pNext = &physicalDeviceFeatures2,
+        .pNext = &timelineSemaphoreFeatures,
         .queueCreateInfoCount = uint32_t(std::size(queueCreateInfos)),
         .pQueueCreateInfos = std::data(queueCreateInfos),
 //			.enabledLayerCount = std::size(enabledLayers),
 //			.ppEnabledLayerNames = std::data(enabledLayers),
-        .enabledExtensionCount = std::size(deviceExtensions),
+        .enabledExtensionCount = static_cast<uint32_t>(std::size(deviceExtensions)),
         .ppEnabledExtensionNames = std::data(deviceExtensions),
         .pEnabledFeatures = &features
     };
@@ -861,6 +958,11 @@ void VulkanGfxDevice::_createLogicalDevice() {
 
     _presentQueue = _logicalDevice.getQueue(_presentFamily, 0);
     _graphicsQueue = _logicalDevice.getQueue(_graphicsFamily, 0);
+    _transferQueue = _logicalDevice.getQueue(_transferFamily, 0);
+
+    if (_transferFamily != _graphicsFamily) {
+        spdlog::info("Using dedicated transfer queue family {}", _transferFamily);
+    }
 }
 
 void VulkanGfxDevice::_createMemoryResource() {
@@ -902,6 +1004,7 @@ void VulkanGfxDevice::_createMemoryResource() {
     };
 
     const auto allocatorCreateInfo = VmaAllocatorCreateInfo{
+        .flags = _hasMemoryBudget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : VmaAllocatorCreateFlags{},
         .physicalDevice = _physicalDevice,
         .device = _logicalDevice,
         .pVulkanFunctions = &functions,
@@ -910,77 +1013,697 @@ void VulkanGfxDevice::_createMemoryResource() {
     };
 
     vmaCreateAllocator(&allocatorCreateInfo, &_allocator);
+
+    // Integrated GPUs map all of their memory, there the heap is plain system memory.
+    if (_physicalDevice.getProperties().deviceType == vk::PhysicalDeviceType::eIntegratedGpu) {
+        return;
+    }
+
+    const VkPhysicalDeviceMemoryProperties* properties;
+    vmaGetMemoryProperties(_allocator, &properties);
+
+    const auto required = VkMemoryPropertyFlags{VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+    for (uint32_t type = 0; type < properties->memoryTypeCount; ++type) {
+        const auto& memoryType = properties->memoryTypes[type];
+        const auto size = properties->memoryHeaps[memoryType.heapIndex].size;
+        if ((memoryType.propertyFlags & required) == required && size > kResizableBarMinHeapSize) {
+            _resizableBarHeapSize = std::max(_resizableBarHeapSize, size);
+        }
+    }
+    if (_resizableBarHeapSize != 0) {
+        _resizableBarBudget = _resizableBarHeapSize / 2;
+        spdlog::info("Resizable BAR: {} MiB host-visible device-local heap", _resizableBarHeapSize / (1024 * 1024));
+    }
+}
+
+// Without a dedicated transfer family the transfer timeline is never signaled.
+void VulkanGfxDevice::_createTimelines() {
+    _graphicsTimeline = std::make_unique<VulkanTimeline>(_logicalDevice);
+    _transferTimeline = std::make_unique<VulkanTimeline>(_logicalDevice);
+}
+
+void VulkanGfxDevice::_createStagingRing() {
+    _stagingRing = std::make_unique<VulkanStagingRing>(_logicalDevice, _allocator, _graphicsQueue, _graphicsFamily, *_graphicsTimeline, _transferQueue, _transferFamily, *_transferTimeline, kStagingRingCapacity);
+}
+
+void VulkanGfxDevice::_createSamplerCache() {
+    const auto limits = _physicalDevice.getProperties().limits;
+    _samplerCache = std::make_unique<VulkanSamplerCache>(_logicalDevice, limits.maxSamplerAnisotropy);
+}
+
+void VulkanGfxDevice::FlushUploads() {
+    _stagingRing->flush();
+}
+
+void VulkanGfxDevice::SetFrameCount(uint32_t frameCount) {
+    assert(frameCount <= 32 && _materials.empty());
+    _frameCount = frameCount;
+    _frameAllocator = std::make_unique<VulkanFrameAllocator>(_allocator, frameCount, kFrameAllocatorCapacity);
+
+    const auto limits = _physicalDevice.getProperties().limits;
+    _uniformRing = std::make_unique<VulkanUniformRing>(_allocator, frameCount, kUniformRingCapacity, limits.minUniformBufferOffsetAlignment);
+}
+
+void VulkanGfxDevice::BeginFrame(uint32_t frameIndex) {
+    _frameIndex = frameIndex;
+    _collectDestructions(false);
+    _defragment();
+    _frameAllocator->beginFrame(frameIndex);
+    _uniformRing->beginFrame(frameIndex);
+    _writePendingDescriptors();
+}
+
+// The frame is the last submission of its iteration, it comes after the uploads and any
+// blocking copies, so its value covers every use of the resources released up to now.
+void VulkanGfxDevice::EndFrame() {
+    const auto value = _graphicsTimeline->getSubmittedValue();
+    for (auto it = _deferredDestructions.rbegin(); it != _deferredDestructions.rend() && it->value == 0; ++it) {
+        it->value = value;
+    }
+}
+
+// The value is not known yet, the frame being recorded is submitted after the upload batch
+// that may still write the resource, and EndFrame fills it in.
+void VulkanGfxDevice::_deferDestruction(std::function<void()> destroy) {
+    _deferredDestructions.emplace_back(DeferredDestruction{
+        .value = 0,
+        .destroy = std::move(destroy)
+    });
+}
+
+void VulkanGfxDevice::_collectDestructions(bool all) {
+    while (!_deferredDestructions.empty()) {
+        auto& front = _deferredDestructions.front();
+        if (!all && (front.value == 0 || !_graphicsTimeline->isComplete(front.value))) {
+            break;
+        }
+        front.destroy();
+        _deferredDestructions.pop_front();
+    }
 }
 
 void VulkanGfxDevice::WaitIdle() {
-    _logicalDevice.waitIdle();
+    _transferTimeline->wait(_transferTimeline->getSubmittedValue());
+    _graphicsTimeline->wait(_graphicsTimeline->getSubmittedValue());
 }
 
-auto VulkanGfxDevice::CreateGPUFence() -> void* {
-    return static_cast<VkFence>(_logicalDevice.createFence({}));
+auto VulkanGfxDevice::GetDeviceLocalBudget() const -> VmaBudget {
+    const VkPhysicalDeviceMemoryProperties* properties;
+    vmaGetMemoryProperties(_allocator, &properties);
+
+    auto budgets = std::array<VmaBudget, VK_MAX_MEMORY_HEAPS>{};
+    vmaGetHeapBudgets(_allocator, budgets.data());
+
+    auto total = VmaBudget{};
+    for (uint32_t heap = 0; heap < properties->memoryHeapCount; ++heap) {
+        if (properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            total.statistics.blockCount += budgets[heap].statistics.blockCount;
+            total.statistics.allocationCount += budgets[heap].statistics.allocationCount;
+            total.statistics.blockBytes += budgets[heap].statistics.blockBytes;
+            total.statistics.allocationBytes += budgets[heap].statistics.allocationBytes;
+            total.usage += budgets[heap].usage;
+            total.budget += budgets[heap].budget;
+        }
+    }
+    return total;
 }
 
-void VulkanGfxDevice::DestroyGPUFence(void* fence) {
-    _logicalDevice.destroyFence(static_cast<VkFence>(fence));
+auto VulkanGfxDevice::GetMemoryStatistics() const -> MemoryStatistics {
+    const VkPhysicalDeviceMemoryProperties* properties;
+    vmaGetMemoryProperties(_allocator, &properties);
+
+    auto budgets = std::array<VmaBudget, VK_MAX_MEMORY_HEAPS>{};
+    vmaGetHeapBudgets(_allocator, budgets.data());
+
+    VmaTotalStatistics total;
+    vmaCalculateStatistics(_allocator, &total);
+
+    auto statistics = MemoryStatistics{
+        .categories = _memoryCategories
+    };
+    for (uint32_t heap = 0; heap < properties->memoryHeapCount; ++heap) {
+        const auto& detailed = total.memoryHeap[heap];
+        statistics.heaps.emplace_back(MemoryHeapStatistics{
+            .size = properties->memoryHeaps[heap].size,
+            .deviceLocal = (properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+            .budget = budgets[heap].budget,
+            .usage = budgets[heap].usage,
+            .blockCount = detailed.statistics.blockCount,
+            .allocationCount = detailed.statistics.allocationCount,
+            .blockBytes = detailed.statistics.blockBytes,
+            .allocationBytes = detailed.statistics.allocationBytes,
+            .unusedRangeCount = detailed.unusedRangeCount,
+            .largestUnusedRange = detailed.unusedRangeCount != 0 ? detailed.unusedRangeSizeMax : 0
+        });
+    }
+    return statistics;
 }
 
-void VulkanGfxDevice::WaitOnGPUFence(void* fence) {
-    const auto vk_fence = static_cast<vk::Fence>(static_cast<VkFence>(fence));
-    _logicalDevice.waitForFences(vk_fence, false, std::numeric_limits<uint64_t>::max());
+// Every block and allocation, in the JSON format VMA's tools read.
+auto VulkanGfxDevice::BuildMemoryStatisticsString() const -> std::string {
+    char* json;
+    vmaBuildStatsString(_allocator, &json, VK_TRUE);
+    auto result = std::string(json);
+    vmaFreeStatsString(_allocator, json);
+    return result;
 }
 
-void VulkanGfxDevice::ExecuteCommandBuffer(const CommandBuffer &cmd, void* fence) {
-    const auto vk_fence = static_cast<vk::Fence>(static_cast<VkFence>(fence));
+void VulkanGfxDevice::_trackAllocation(MemoryCategory category, vk::DeviceSize bytes) {
+    auto& statistics = _memoryCategories[static_cast<size_t>(category)];
+    statistics.count += 1;
+    statistics.bytes += bytes;
+}
 
-    const auto commandBuffers = std::array{ *cmd };
-    const auto submitInfo = vk::SubmitInfo{}
-        .setCommandBuffers(commandBuffers);
+void VulkanGfxDevice::_untrackAllocation(MemoryCategory category, vk::DeviceSize bytes) {
+    auto& statistics = _memoryCategories[static_cast<size_t>(category)];
+    statistics.count -= 1;
+    statistics.bytes -= bytes;
+}
 
-    _graphicsQueue.submit(1, &submitInfo, vk_fence);
+// What the buffer takes from its memory block or pool, with alignment and stride padding, as
+// for textures.
+auto VulkanGfxDevice::_getAllocationSize(const VulkanGraphicsBuffer& buffer) const -> vk::DeviceSize {
+    if (buffer.pool != nullptr) {
+        VmaVirtualAllocationInfo allocationInfo;
+        vmaGetVirtualAllocationInfo(buffer.range.block, buffer.range.allocation, &allocationInfo);
+        return allocationInfo.size;
+    }
+    if (buffer.allocation == nullptr) {
+        return 0;
+    }
+    VmaAllocationInfo allocationInfo;
+    vmaGetAllocationInfo(_allocator, buffer.allocation, &allocationInfo);
+    return allocationInfo.size;
 }
 
-auto VulkanGfxDevice::CreateBuffer(GraphicsBuffer::Target target, int size) -> void* {
-    const auto bufferCreateInfo = static_cast<VkBufferCreateInfo>(vk::BufferCreateInfo {
-        .size = static_cast<vk::DeviceSize>(size),
-        .usage = GetBufferUsageFromTarget(target)
+void VulkanGfxDevice::SetResizableBarBudget(vk::DeviceSize bytes) {
+    _resizableBarBudget = std::min(bytes, _resizableBarHeapSize);
+}
+
+auto VulkanGfxDevice::GetResizableBarBudget() const -> vk::DeviceSize {
+    return _resizableBarBudget;
+}
+
+void VulkanGfxDevice::RequestDefragmentation() {
+    _defragmentationRequested = true;
+}
+
+auto VulkanGfxDevice::_isFragmented() const -> bool {
+    auto blockBytes = uint64_t{};
+    auto allocationBytes = uint64_t{};
+    for (const auto& heap : GetMemoryStatistics().heaps) {
+        if (heap.deviceLocal) {
+            blockBytes += heap.blockBytes;
+            allocationBytes += heap.allocationBytes;
+        }
+    }
+    const auto unused = blockBytes - allocationBytes;
+    return unused >= kDefragmentationMinUnusedBytes && unused > blockBytes / 4;
+}
+
+// A pass copies the resources it moves ahead of the frame through the upload batch and
+// switches them to their new handles right away. VMA releases the old memory once the frame
+// has retired, and only then is the next pass started.
+void VulkanGfxDevice::_defragment() {
+    if (_defragmentation == nullptr) {
+        if (!_defragmentationRequested && ++_framesSinceDefragmentationCheck < kDefragmentationCheckInterval) {
+            return;
+        }
+        _framesSinceDefragmentationCheck = 0;
+        if (!std::exchange(_defragmentationRequested, false) && !_isFragmented()) {
+            return;
+        }
+
+        const auto defragmentationInfo = VmaDefragmentationInfo{
+            .flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+            .maxBytesPerPass = kDefragmentationMaxBytesPerPass,
+            .maxAllocationsPerPass = kDefragmentationMaxMovesPerPass
+        };
+        if (const auto result = vmaBeginDefragmentation(_allocator, &defragmentationInfo, &_defragmentation); result != VK_SUCCESS) {
+            spdlog::warn("Failed to begin defragmentation ({}), retrying after the next check interval", vk::to_string(static_cast<vk::Result>(result)));
+            _defragmentation = nullptr;
+            return;
+        }
+    }
+    if (_defragmentationPassPending) {
+        return;
+    }
+
+    VmaDefragmentationPassMoveInfo pass;
+    if (vmaBeginDefragmentationPass(_allocator, _defragmentation, &pass) == VK_SUCCESS) {
+        _endDefragmentation();
+        return;
+    }
+
+    auto moved = std::unordered_set<const void*>{};
+    auto cmd = _stagingRing->getGraphicsCommandBuffer();
+    for (auto& move : std::span(pass.pMoves, pass.moveCount)) {
+        if (const auto it = _movableBuffers.find(move.srcAllocation); it != _movableBuffers.end()) {
+            _moveBuffer(cmd, *it->second, move.dstTmpAllocation);
+            moved.emplace(it->second);
+            continue;
+        }
+        // A texture that was never uploaded has no layout to copy from.
+        if (const auto it = _movableTextures.find(move.srcAllocation); it != _movableTextures.end() && it->second->layout == vk::ImageLayout::eShaderReadOnlyOptimal) {
+            _moveTexture(cmd, *it->second, move.dstTmpAllocation);
+            moved.emplace(it->second);
+            continue;
+        }
+        move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+    }
+
+    // What VMA proposes is all in pools and rings, another pass would propose it again.
+    if (moved.empty()) {
+        vmaEndDefragmentationPass(_allocator, _defragmentation, &pass);
+        _endDefragmentation();
+        return;
+    }
+
+    _rebindMovedResources(moved);
+
+    _defragmentationPassPending = true;
+    _deferDestruction([this, pass]() mutable {
+        _defragmentationPassPending = false;
+        if (vmaEndDefragmentationPass(_allocator, _defragmentation, &pass) == VK_SUCCESS) {
+            _endDefragmentation();
+        }
+    });
+}
+
+void VulkanGfxDevice::_endDefragmentation() {
+    VmaDefragmentationStats stats;
+    vmaEndDefragmentation(_allocator, _defragmentation, &stats);
+    _defragmentation = nullptr;
+
+    spdlog::info(
+        "Defragmentation moved {} allocations ({} bytes), freed {} blocks ({} bytes)",
+        stats.allocationsMoved,
+        stats.bytesMoved,
+        stats.deviceMemoryBlocksFreed,
+        stats.bytesFreed
+    );
+}
+
+// Static buffers are only written by staged copies, which may still be in this frame's batch.
+void VulkanGfxDevice::_moveBuffer(vk::CommandBuffer cmd, VulkanGraphicsBuffer& buffer, VmaAllocation allocation) {
+    const auto newBuffer = _logicalDevice.createBuffer(vk::BufferCreateInfo{
+        .size = buffer.size,
+        .usage = buffer.usage
+    });
+    vmaBindBufferMemory(_allocator, allocation, newBuffer);
+
+    const auto uploadBarrier = vk::BufferMemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = buffer.buffer,
+        .offset = 0,
+        .size = buffer.size
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, uploadBarrier, {});
+
+    const auto region = vk::BufferCopy{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = buffer.size
+    };
+    cmd.copyBuffer(buffer.buffer, newBuffer, region);
+
+    const auto barrier = vk::BufferMemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = GetBufferReadAccess(buffer.usage) | vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = newBuffer,
+        .offset = 0,
+        .size = buffer.size
+    };
+    cmd.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        GetBufferReadStages(buffer.usage) | vk::PipelineStageFlagBits::eTransfer,
+        {}, {}, barrier, {}
+    );
+
+    _deferDestruction([this, oldBuffer = buffer.buffer] {
+        _logicalDevice.destroyBuffer(oldBuffer);
+    });
+    buffer.buffer = newBuffer;
+}
+
+// The old image goes from shader reads to a copy source after the frames in flight have read
+// it, the new one ends up where the old one was.
+void VulkanGfxDevice::_moveTexture(vk::CommandBuffer cmd, VulkanTexture& texture, VmaAllocation allocation) {
+    const auto aspect = GetImageAspectFromFormat(texture.format);
+    const auto newImage = _logicalDevice.createImage(vk::ImageCreateInfo{
+        .imageType = vk::ImageType::e2D,
+        .format = texture.format,
+        .extent = {
+            .width = texture.extent.width,
+            .height = texture.extent.height,
+            .depth = 1
+        },
+        .mipLevels = texture.mipLevels,
+        .arrayLayers = 1,
+        .usage = GetImageUsageFromFormat(texture.format)
     });
+    vmaBindImageMemory(_allocator, allocation, newImage);
+
+    const auto subresourceRange = vk::ImageSubresourceRange{
+        .aspectMask = aspect,
+        .baseMipLevel = 0,
+        .levelCount = texture.mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1
+    };
+    const auto copyBarriers = std::array{
+        vk::ImageMemoryBarrier{
+            .srcAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferWrite,
+            .dstAccessMask = vk::AccessFlagBits::eTransferRead,
+            .oldLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+            .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = texture.image,
+            .subresourceRange = subresourceRange
+        },
+        vk::ImageMemoryBarrier{
+            .srcAccessMask = {},
+            .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+            .oldLayout = vk::ImageLayout::eUndefined,
+            .newLayout = vk::ImageLayout::eTransferDstOptimal,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = newImage,
+            .subresourceRange = subresourceRange
+        }
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, copyBarriers);
 
-    const auto allocCreateInfo = VmaAllocationCreateInfo {
-        .usage = GetMemoryUsageFromTarget(target)
+    auto regions = std::vector<vk::ImageCopy>{};
+    for (uint32_t level = 0; level < texture.mipLevels; ++level) {
+        const auto subresource = vk::ImageSubresourceLayers{
+            .aspectMask = aspect,
+            .mipLevel = level,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        };
+        regions.emplace_back(vk::ImageCopy{
+            .srcSubresource = subresource,
+            .dstSubresource = subresource,
+            .extent = {
+                .width = std::max(texture.extent.width >> level, 1u),
+                .height = std::max(texture.extent.height >> level, 1u),
+                .depth = 1
+            }
+        });
+    }
+    cmd.copyImage(texture.image, vk::ImageLayout::eTransferSrcOptimal, newImage, vk::ImageLayout::eTransferDstOptimal, regions);
+
+    const auto useBarrier = vk::ImageMemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+        .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = newImage,
+        .subresourceRange = subresourceRange
     };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, useBarrier);
+
+    const auto newImageView = _logicalDevice.createImageView(vk::ImageViewCreateInfo{
+        .image = newImage,
+        .viewType = vk::ImageViewType::e2D,
+        .format = texture.format,
+        .subresourceRange = subresourceRange
+    });
+
+    _deferDestruction([this, oldImage = texture.image, oldImageView = texture.imageView] {
+        _logicalDevice.destroyImageView(oldImageView);
+        _logicalDevice.destroyImage(oldImage);
+    });
+    texture.image = newImage;
+    texture.imageView = newImageView;
+}
+
+// Each frame's set is written when that frame begins, this one's right after the pass.
+void VulkanGfxDevice::_rebindMovedResources(const std::unordered_set<const void*>& moved) {
+    for (const auto material : _materials) {
+        for (const auto& [index, texture] : material->textures) {
+            if (moved.contains(texture)) {
+                _invalidateDescriptor(*material, index);
+            }
+        }
+        for (const auto& [index, buffer] : material->constantBuffers) {
+            if (moved.contains(buffer)) {
+                _invalidateDescriptor(*material, index);
+            }
+        }
+    }
+}
+
+void VulkanGfxDevice::WaitOnGPUFence(uint64_t value) {
+    _graphicsTimeline->wait(value);
+}
+
+auto VulkanGfxDevice::ExecuteCommandBuffer(const CommandBuffer &cmd) -> uint64_t {
+    const auto value = _graphicsTimeline->next();
+    const auto semaphore = _graphicsTimeline->getSemaphore();
+
+    const auto commandBuffers = std::array{ *cmd };
+    const auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}
+        .setSignalSemaphoreValues(value);
+    const auto submitInfo = vk::SubmitInfo{
+        .pNext = &timelineSubmitInfo
+    }.setCommandBuffers(commandBuffers).setSignalSemaphores(semaphore);
+
+    _graphicsQueue.submit(1, &submitInfo, nullptr);
+    return value;
+}
+
+// Host-visible buffers stay mapped and are kept in coherent memory, writes need neither a map
+// call nor a flush.
+auto VulkanGfxDevice::CreateBuffer(GraphicsBuffer::Target target, int size, GraphicsBuffer::Usage usage, int stride) -> void* {
+    const auto bufferUsage = GetBufferUsageFromTarget(target, usage);
+    const auto memoryUsage = GetMemoryUsageFromTarget(target, usage);
+    const auto category = GetMemoryCategoryFromTarget(target);
+
+    // Buffers the CPU writes, static ones through their uploads, go to the Resizable BAR heap
+    // while it is under budget. Anything that does not fit falls back to its usual memory.
+    // Pooled buffers are charged by the blocks their pool holds, the others by their size.
+    const auto written = usage == GraphicsBuffer::Usage::Static || memoryUsage == VMA_MEMORY_USAGE_CPU_TO_GPU;
+    const auto resizableBar = written && _resizableBarUsage + static_cast<vk::DeviceSize>(size) <= _resizableBarBudget;
+
+    const auto pooled = target == GraphicsBuffer::Target::Vertex || target == GraphicsBuffer::Target::Index;
+    if (pooled && size > 0) {
+        const auto allocate = [&](VmaMemoryUsage poolMemoryUsage) -> VulkanGraphicsBuffer* {
+            const auto placed = poolMemoryUsage == VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+            const auto grow = !placed || _resizableBarUsage + kBufferPoolBlockSize <= _resizableBarBudget;
+
+            auto& pool = _getBufferPool(bufferUsage, poolMemoryUsage);
+            const auto blockCount = pool.getBlockCount();
+            const auto range = pool.allocate(static_cast<vk::DeviceSize>(size), static_cast<vk::DeviceSize>(stride), grow);
+            if (!range) {
+                return nullptr;
+            }
+            if (placed) {
+                _resizableBarUsage += (pool.getBlockCount() - blockCount) * kBufferPoolBlockSize;
+            }
+            return new VulkanGraphicsBuffer {
+                .buffer = range->buffer,
+                .usage = bufferUsage,
+                .data = usage == GraphicsBuffer::Usage::Static ? nullptr : range->data,
+                .hostData = range->data,
+                .createdAt = _graphicsTimeline->getSubmittedValue(),
+                .resizableBar = placed,
+                .offset = range->offset,
+                .size = static_cast<vk::DeviceSize>(size),
+                .stride = static_cast<vk::DeviceSize>(stride),
+                .pool = &pool,
+                .range = *range,
+                .category = category
+            };
+        };
+
+        auto vk_buffer = written && _resizableBarHeapSize != 0 ? allocate(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE) : nullptr;
+        if (vk_buffer == nullptr) {
+            vk_buffer = allocate(memoryUsage);
+        }
+        if (vk_buffer != nullptr) {
+            _trackAllocation(category, _getAllocationSize(*vk_buffer));
+            return vk_buffer;
+        }
+    }
+
+    const auto bufferCreateInfo = static_cast<VkBufferCreateInfo>(vk::BufferCreateInfo {
+        .size = static_cast<vk::DeviceSize>(size),
+        .usage = bufferUsage
+    });
 
     VkBuffer buffer;
     VmaAllocation allocation;
     VmaAllocationInfo allocationInfo;
 
-    vmaCreateBuffer(
-        _allocator,
-        &bufferCreateInfo,
-        &allocCreateInfo,
-        &buffer,
-        &allocation,
-        &allocationInfo
-    );
+    auto result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    if (resizableBar) {
+        const auto allocCreateInfo = VmaAllocationCreateInfo {
+            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT,
+            .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+            .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        };
+        result = vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, &buffer, &allocation, &allocationInfo);
+    }
+    const auto placed = result == VK_SUCCESS;
+    if (!placed) {
+        const auto mapped = memoryUsage != VMA_MEMORY_USAGE_GPU_ONLY;
+
+        const auto allocCreateInfo = VmaAllocationCreateInfo {
+            .flags = mapped ? VMA_ALLOCATION_CREATE_MAPPED_BIT : VmaAllocationCreateFlags{},
+            .usage = memoryUsage,
+            .requiredFlags = mapped ? VkMemoryPropertyFlags{VK_MEMORY_PROPERTY_HOST_COHERENT_BIT} : VkMemoryPropertyFlags{}
+        };
+
+        vmaCreateBuffer(
+            _allocator,
+            &bufferCreateInfo,
+            &allocCreateInfo,
+            &buffer,
+            &allocation,
+            &allocationInfo
+        );
+    }
 
-    return new VulkanGraphicsBuffer {
+    const auto hostData = static_cast<std::byte*>(allocationInfo.pMappedData);
+    const auto vk_buffer = new VulkanGraphicsBuffer {
         .buffer = buffer,
         .allocation = allocation,
-        .allocationInfo = allocationInfo
+        .allocationInfo = allocationInfo,
+        .usage = bufferUsage,
+        .data = usage == GraphicsBuffer::Usage::Static ? nullptr : hostData,
+        .hostData = hostData,
+        .createdAt = _graphicsTimeline->getSubmittedValue(),
+        .resizableBar = placed,
+        .size = static_cast<vk::DeviceSize>(size),
+        .stride = static_cast<vk::DeviceSize>(stride),
+        .category = category
     };
+    _trackAllocation(category, _getAllocationSize(*vk_buffer));
+    // Moving a mapped buffer would leave its pointer behind.
+    if (placed) {
+        _resizableBarUsage += vk_buffer->size;
+    } else if (usage == GraphicsBuffer::Usage::Static) {
+        _movableBuffers.emplace(allocation, vk_buffer);
+    }
+    return vk_buffer;
 }
 
 void VulkanGfxDevice::DestroyBuffer(void* buffer) {
-    auto vk_buffer = static_cast<VulkanGraphicsBuffer*>(buffer);
-    vmaDestroyBuffer(_allocator, vk_buffer->buffer, vk_buffer->allocation);
-    delete vk_buffer;
+    if (const auto allocation = static_cast<VulkanGraphicsBuffer*>(buffer)->allocation) {
+        _movableBuffers.erase(allocation);
+    }
+    for (const auto material : _materials) {
+        std::erase_if(material->constantBuffers, [buffer](const auto& binding) {
+            return binding.second == buffer;
+        });
+    }
+    _deferDestruction([this, vk_buffer = static_cast<VulkanGraphicsBuffer*>(buffer)] {
+        _untrackAllocation(vk_buffer->category, _getAllocationSize(*vk_buffer));
+        if (vk_buffer->pool != nullptr) {
+            const auto blockCount = vk_buffer->pool->getBlockCount();
+            vk_buffer->pool->free(vk_buffer->range);
+            if (vk_buffer->resizableBar) {
+                _resizableBarUsage -= (blockCount - vk_buffer->pool->getBlockCount()) * kBufferPoolBlockSize;
+            }
+        } else {
+            if (vk_buffer->resizableBar) {
+                _resizableBarUsage -= vk_buffer->size;
+            }
+            vmaDestroyBuffer(_allocator, vk_buffer->buffer, vk_buffer->allocation);
+        }
+        delete vk_buffer;
+    });
 }
 
+// A static buffer is only read by submissions made after its creation, until then the host
+// can write it without ordering against the GPU.
 void VulkanGfxDevice::UpdateBuffer(void* buffer, std::span<const std::byte> bytes, size_t offset) {
     auto vk_buffer = static_cast<VulkanGraphicsBuffer*>(buffer);
-    void* ptr = nullptr;
-    vmaMapMemory(_allocator, vk_buffer->allocation, &ptr);
-    std::copy(bytes.begin(), bytes.end(), static_cast<std::byte*>(ptr) + offset);
-    vmaUnmapMemory(_allocator, vk_buffer->allocation);
+    if (vk_buffer->data != nullptr) {
+        std::memcpy(vk_buffer->data + offset, bytes.data(), bytes.size());
+        return;
+    }
+    if (vk_buffer->hostData != nullptr && vk_buffer->createdAt == _graphicsTimeline->getSubmittedValue()) {
+        std::memcpy(vk_buffer->hostData + offset, bytes.data(), bytes.size());
+        return;
+    }
+    _stageBuffer(*vk_buffer, bytes, offset);
+}
+
+// The copies go into the upload batch of the staging ring, which reaches the graphics queue
+// ahead of the frame. Writes larger than half the ring are split, so each piece only waits for
+// the space it needs. The first barrier keeps the copies behind earlier reads and writes, the
+// last one makes them visible to the stages that read the buffer.
+void VulkanGfxDevice::_stageBuffer(VulkanGraphicsBuffer& buffer, std::span<const std::byte> bytes, size_t offset) {
+    assert(buffer.usage & vk::BufferUsageFlagBits::eTransferDst);
+    if (bytes.empty()) {
+        return;
+    }
+
+    const auto readStages = GetBufferReadStages(buffer.usage);
+    const auto readAccess = GetBufferReadAccess(buffer.usage);
+    const auto chunkSize = _stagingRing->getCapacity() / 2;
+
+    auto barrier = vk::BufferMemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = buffer.buffer,
+        .offset = buffer.offset + offset,
+        .size = bytes.size()
+    };
+    _stagingRing->getGraphicsCommandBuffer().pipelineBarrier(
+        readStages | vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eTransfer,
+        {}, {}, barrier, {}
+    );
+
+    for (size_t done = 0; done < bytes.size(); done += chunkSize) {
+        const auto chunk = bytes.subspan(done, std::min<size_t>(chunkSize, bytes.size() - done));
+        const auto allocation = *_stagingRing->allocate(chunk.size(), 16);
+        std::memcpy(allocation.data, chunk.data(), chunk.size());
+
+        const auto region = vk::BufferCopy{
+            .srcOffset = allocation.offset,
+            .dstOffset = buffer.offset + offset + done,
+            .size = chunk.size()
+        };
+        _stagingRing->getGraphicsCommandBuffer().copyBuffer(allocation.buffer, buffer.buffer, region);
+    }
+
+    barrier.setDstAccessMask(readAccess | vk::AccessFlagBits::eTransferRead);
+    _stagingRing->getGraphicsCommandBuffer().pipelineBarrier(
+        vk::PipelineStageFlagBits::eTransfer,
+        readStages | vk::PipelineStageFlagBits::eTransfer,
+        {}, {}, barrier, {}
+    );
+}
+
+auto VulkanGfxDevice::_getBufferPool(vk::BufferUsageFlags usage, VmaMemoryUsage memoryUsage) -> VulkanBufferPool& {
+    auto& pool = _bufferPools[{static_cast<VkBufferUsageFlags>(usage), memoryUsage}];
+    if (!pool) {
+        pool = std::make_unique<VulkanBufferPool>(_allocator, usage, memoryUsage, kBufferPoolBlockSize);
+    }
+    return *pool;
+}
+
+auto VulkanGfxDevice::MapBuffer(void* buffer) -> std::span<std::byte> {
+    auto vk_buffer = static_cast<VulkanGraphicsBuffer*>(buffer);
+    if (vk_buffer->data == nullptr) {
+        return {};
+    }
+    return std::span(vk_buffer->data, vk_buffer->size);
 }
 
 auto VulkanGfxDevice::CreateCommandPool() -> void* {
@@ -1013,7 +1736,21 @@ void VulkanGfxDevice::FreeCommandBuffer(void* pool, void* cmd) {
     _logicalDevice.freeCommandBuffers(vk_pool, { vk_cmd });
 }
 
-auto VulkanGfxDevice::CreateTexture(glm::u32 width, glm::u32 height, vk::Format format) -> void* {
+auto VulkanGfxDevice::SupportsLinearBlit(vk::Format format) const -> bool {
+    const auto required = vk::FormatFeatureFlagBits::eBlitSrc
+        | vk::FormatFeatureFlagBits::eBlitDst
+        | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    const auto features = _physicalDevice.getFormatProperties(format).optimalTilingFeatures;
+    return (features & required) == required;
+}
+
+auto VulkanGfxDevice::SupportsTextureCompressionBC() const -> bool {
+    return _hasTextureCompressionBC;
+}
+
+auto VulkanGfxDevice::CreateTexture(glm::u32 width, glm::u32 height, vk::Format format, glm::u32 mipLevels, const SamplerDescriptor& sampler) -> void* {
+    const auto usage = GetImageUsageFromFormat(format);
+
     const auto imageCreateInfo = static_cast<VkImageCreateInfo>(vk::ImageCreateInfo{
         .imageType = vk::ImageType::e2D,
         .format = format,
@@ -1022,9 +1759,9 @@ auto VulkanGfxDevice::CreateTexture(glm::u32 width, glm::u32 height, vk::Format
             .height = height,
             .depth = 1
         },
-        .mipLevels = 1,
+        .mipLevels = mipLevels,
         .arrayLayers = 1,
-        .usage = GetImageUsageFromFormat(format)
+        .usage = usage
     });
 
     VkImage image;
@@ -1033,7 +1770,11 @@ auto VulkanGfxDevice::CreateTexture(glm::u32 width, glm::u32 height, vk::Format
     const auto allocationCreateInfo = VmaAllocationCreateInfo{
         .usage = VMA_MEMORY_USAGE_GPU_ONLY
     };
-    vmaCreateImage(_allocator, &imageCreateInfo, &allocationCreateInfo, &image, &allocation, nullptr);
+    VmaAllocationInfo allocationInfo;
+    vmaCreateImage(_allocator, &imageCreateInfo, &allocationCreateInfo, &image, &allocation, &allocationInfo);
+
+    const auto category = IsDepthFormat(format) ? MemoryCategory::DepthStencil : MemoryCategory::Texture;
+    _trackAllocation(category, allocationInfo.size);
 
     const auto imageViewCreateInfo = vk::ImageViewCreateInfo{
         .image = image,
@@ -1042,69 +1783,100 @@ auto VulkanGfxDevice::CreateTexture(glm::u32 width, glm::u32 height, vk::Format
         .subresourceRange = {
             .aspectMask = GetImageAspectFromFormat(format),
             .baseMipLevel = 0,
-            .levelCount = 1,
+            .levelCount = mipLevels,
             .baseArrayLayer = 0,
             .layerCount = 1
         }
     };
     const auto imageView = _logicalDevice.createImageView(imageViewCreateInfo);
 
-    const auto sampler = IsDepthFormat(format) ? nullptr : _logicalDevice.createSampler(vk::SamplerCreateInfo{
-//        .magFilter = vk::Filter::eLinear,
-//        .minFilter = vk::Filter::eLinear,
-//        .mipmapMode = vk::SamplerMipmapMode::eLinear,
-        .addressModeU = vk::SamplerAddressMode::eRepeat,
-        .addressModeV = vk::SamplerAddressMode::eRepeat,
-        .addressModeW = vk::SamplerAddressMode::eRepeat,
-        .maxAnisotropy = 1.0f,
-        .minLod = -1000,
-        .maxLod = 1000
-    });
-
-    return new VulkanTexture{
+    const auto vk_texture = new VulkanTexture{
         .image = image,
-        .sampler = sampler,
+        .sampler = IsDepthFormat(format) ? vk::Sampler{} : _samplerCache->get(sampler),
         .imageView = imageView,
-        .allocation = allocation
+        .allocation = allocation,
+        .mipLevels = mipLevels,
+        .format = format,
+        .extent = {width, height},
+        .category = category
     };
+    if (category == MemoryCategory::Texture) {
+        _movableTextures.emplace(allocation, vk_texture);
+    }
+    return vk_texture;
 }
 
 auto VulkanGfxDevice::CreateTexture(VkImage image, VkImageView imageView, VkSampler sampler, VmaAllocation allocation) -> void* {
+    if (allocation) {
+        VmaAllocationInfo allocationInfo;
+        vmaGetAllocationInfo(_allocator, allocation, &allocationInfo);
+        _trackAllocation(MemoryCategory::Texture, allocationInfo.size);
+    }
     return new VulkanTexture{
         .image = image,
         .sampler = sampler,
+        .ownsSampler = sampler != VK_NULL_HANDLE && !_samplerCache->contains(sampler),
         .imageView = imageView,
         .allocation = allocation
     };
 }
 
 void VulkanGfxDevice::DestroyTexture(void* texture) {
-    const auto vk_texture = static_cast<VulkanTexture*>(texture);
-
-    if (vk_texture->allocation) {
-        vmaDestroyImage(_allocator, vk_texture->image, vk_texture->allocation);
+    if (const auto allocation = static_cast<VulkanTexture*>(texture)->allocation) {
+        _movableTextures.erase(allocation);
     }
-    if (vk_texture->sampler) {
-        _logicalDevice.destroySampler(vk_texture->sampler, nullptr);
+    for (const auto material : _materials) {
+        std::erase_if(material->textures, [texture](const auto& binding) {
+            return binding.second == texture;
+        });
     }
-    _logicalDevice.destroyImageView(vk_texture->imageView, nullptr);
+    _deferDestruction([this, vk_texture = static_cast<VulkanTexture*>(texture)] {
+        if (vk_texture->allocation) {
+            VmaAllocationInfo allocationInfo;
+            vmaGetAllocationInfo(_allocator, vk_texture->allocation, &allocationInfo);
+            _untrackAllocation(vk_texture->category, allocationInfo.size);
+            vmaDestroyImage(_allocator, vk_texture->image, vk_texture->allocation);
+        }
+        // Samplers from the cache are shared and outlive the textures.
+        if (vk_texture->ownsSampler) {
+            _logicalDevice.destroySampler(vk_texture->sampler);
+        }
+        _logicalDevice.destroyImageView(vk_texture->imageView, nullptr);
 
-    delete vk_texture;
+        delete vk_texture;
+    });
+}
+
+void VulkanGfxDevice::SetSampler(void* texture, const SamplerDescriptor& sampler) {
+    auto vk_texture = static_cast<VulkanTexture*>(texture);
+    if (vk_texture->ownsSampler) {
+        _deferDestruction([this, oldSampler = vk_texture->sampler] {
+            _logicalDevice.destroySampler(oldSampler);
+        });
+        vk_texture->ownsSampler = false;
+    }
+    vk_texture->sampler = _samplerCache->get(sampler);
+}
+
+// Stages that declare the same binding share one entry.
+static void AddDescriptorSetLayoutBinding(std::vector<vk::DescriptorSetLayoutBinding>& bindings, uint32_t binding, vk::DescriptorType type, vk::ShaderStageFlagBits stage) {
+    const auto it = std::ranges::find(bindings, binding, &vk::DescriptorSetLayoutBinding::binding);
+    if (it != bindings.end()) {
+        assert(it->descriptorType == type);
+        it->stageFlags |= stage;
+        return;
+    }
+    bindings.emplace_back(vk::DescriptorSetLayoutBinding{
+        .binding = binding,
+        .descriptorType = type,
+        .descriptorCount = 1,
+        .stageFlags = stage,
+        .pImmutableSamplers = nullptr
+    });
 }
 
 auto VulkanGfxDevice::CreateMaterial(Resource const& _resource) -> void* {
     const auto material = new VulkanMaterial();
-    const auto poolSizes = std::array {
-        vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler, 1},
-        vk::DescriptorPoolSize{vk::DescriptorType::eUniformBuffer, 1},
-    };
-    const auto descriptorPoolCreateInfo = vk::DescriptorPoolCreateInfo{
-        .maxSets = 1,
-        .poolSizeCount = static_cast<uint32_t>(std::size(poolSizes)),
-        .pPoolSizes = std::data(poolSizes)
-    };
-    material->descriptorPool = _logicalDevice.createDescriptorPool(descriptorPoolCreateInfo, nullptr);
-
     const auto o = Json::Read::read(memstream{_resource.bytes()}).value();
 
     auto constants = std::vector<vk::PushConstantRange>{};
@@ -1138,29 +1910,26 @@ auto VulkanGfxDevice::CreateMaterial(Resource const& _resource) -> void* {
         for (auto&& resource : resources.uniform_buffers) {
 //                const auto set = glsl.get_decoration(resource.id, spv::DecorationDescriptorSet);
             const auto binding = glsl.get_decoration(resource.id, spv::DecorationBinding);
-            const auto descriptorSetLayoutBinding = vk::DescriptorSetLayoutBinding{
-                .binding = binding,
-                .descriptorType = vk::DescriptorType::eUniformBuffer,
-                .descriptorCount = 1,
-                .stageFlags = stageCreateInfo.stage,
-                .pImmutableSamplers = nullptr
-            };
-            descriptorSetLayoutBindings.emplace_back(descriptorSetLayoutBinding);
+            const auto size = glsl.get_declared_struct_size(glsl.get_type(resource.base_type_id));
+            AddDescriptorSetLayoutBinding(descriptorSetLayoutBindings, binding, vk::DescriptorType::eUniformBufferDynamic, stageCreateInfo.stage);
+
+            const auto it = std::ranges::find(material->uniformBindings, binding, &VulkanUniformBinding::binding);
+            if (it == material->uniformBindings.end()) {
+                material->uniformBindings.emplace_back(VulkanUniformBinding{
+                    .binding = binding,
+                    .size = size,
+                    .perDraw = false
+                });
+            } else {
+                it->size = std::max(it->size, static_cast<vk::DeviceSize>(size));
+            }
         }
 
         for (auto&& resource : resources.sampled_images) {
 //                const auto set = glsl.get_decoration(resource.id, spv::DecorationDescriptorSet);
             const auto binding = glsl.get_decoration(resource.id, spv::DecorationBinding);
 //                const auto type = glsl.get_type(resource.base_type_id);
-
-            const auto descriptorSetLayoutBinding = vk::DescriptorSetLayoutBinding{
-                .binding = binding,
-                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-                .descriptorCount = 1,
-                .stageFlags = stageCreateInfo.stage,
-                .pImmutableSamplers = nullptr
-            };
-            descriptorSetLayoutBindings.emplace_back(descriptorSetLayoutBinding);
+            AddDescriptorSetLayoutBinding(descriptorSetLayoutBindings, binding, vk::DescriptorType::eCombinedImageSampler, stageCreateInfo.stage);
         }
 
         if (!resources.push_constant_buffers.empty()) {
@@ -1184,18 +1953,35 @@ auto VulkanGfxDevice::CreateMaterial(Resource const& _resource) -> void* {
 //            spdlog::info("");
     }
 
+    std::ranges::sort(material->uniformBindings, {}, &VulkanUniformBinding::binding);
+    material->dynamicOffsets.resize(material->uniformBindings.size(), 0);
+
+    auto poolSizes = std::vector<vk::DescriptorPoolSize>{};
+    for (const auto& descriptorSetLayoutBinding : descriptorSetLayoutBindings) {
+        const auto it = std::ranges::find(poolSizes, descriptorSetLayoutBinding.descriptorType, &vk::DescriptorPoolSize::type);
+        if (it == poolSizes.end()) {
+            poolSizes.emplace_back(vk::DescriptorPoolSize{descriptorSetLayoutBinding.descriptorType, _frameCount});
+        } else {
+            it->descriptorCount += _frameCount;
+        }
+    }
+    const auto descriptorPoolCreateInfo = vk::DescriptorPoolCreateInfo{
+        .maxSets = _frameCount
+    }.setPoolSizes(poolSizes);
+    material->descriptorPool = _logicalDevice.createDescriptorPool(descriptorPoolCreateInfo, nullptr);
+
     const auto layoutCreateInfo = vk::DescriptorSetLayoutCreateInfo {}
         .setBindings(descriptorSetLayoutBindings);
 
     material->descriptorSetLayout = _logicalDevice.createDescriptorSetLayout(layoutCreateInfo, nullptr);
 
-    const auto descriptorSetAllocateInfo = vk::DescriptorSetAllocateInfo {
-        .descriptorPool = material->descriptorPool,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &material->descriptorSetLayout
-    };
+    const auto descriptorSetLayouts = std::vector<vk::DescriptorSetLayout>(_frameCount, material->descriptorSetLayout);
+    const auto descriptorSetAllocateInfo = vk::DescriptorSetAllocateInfo{}
+        .setDescriptorPool(material->descriptorPool)
+        .setSetLayouts(descriptorSetLayouts);
 
     material->descriptorSets = _logicalDevice.allocateDescriptorSets(descriptorSetAllocateInfo);
+    material->descriptorSet = material->descriptorSets[_frameIndex];
 
     if (auto a_bindings = o.find("bindings").and_then([](auto&& o) { return o.as_array(); })) {
         for (auto&& binding : *a_bindings) {
@@ -1318,52 +2104,137 @@ auto VulkanGfxDevice::CreateMaterial(Resource const& _resource) -> void* {
         _logicalDevice.destroyShaderModule(stage.module);
     }
 
+    _materials.emplace(material);
     return material;
 }
 
 void VulkanGfxDevice::DestroyMaterial(void* material) {
-    const auto vk_material = static_cast<VulkanMaterial*>(material);
-    _logicalDevice.destroyDescriptorSetLayout(vk_material->descriptorSetLayout, nullptr);
-    _logicalDevice.destroyDescriptorPool(vk_material->descriptorPool, nullptr);
-    _logicalDevice.destroyPipelineLayout(vk_material->pipelineLayout, nullptr);
-    _logicalDevice.destroyPipeline(vk_material->pipeline, nullptr);
-    delete vk_material;
+    _materials.erase(static_cast<VulkanMaterial*>(material));
+    _deferDestruction([this, vk_material = static_cast<VulkanMaterial*>(material)] {
+        _logicalDevice.destroyDescriptorSetLayout(vk_material->descriptorSetLayout, nullptr);
+        _logicalDevice.destroyDescriptorPool(vk_material->descriptorPool, nullptr);
+        _logicalDevice.destroyPipelineLayout(vk_material->pipelineLayout, nullptr);
+        _logicalDevice.destroyPipeline(vk_material->pipeline, nullptr);
+        delete vk_material;
+    });
+}
+
+static auto GetUniformBinding(VulkanMaterial& material, uint32_t index) -> VulkanUniformBinding& {
+    const auto it = std::ranges::find(material.uniformBindings, index, &VulkanUniformBinding::binding);
+    assert(it != material.uniformBindings.end());
+    return *it;
 }
 
 void VulkanGfxDevice::SetConstantBuffer(void* material, uint32_t index, GraphicsBuffer const& buffer) {
     auto vk_material = static_cast<VulkanMaterial*>(material);
     auto vk_buffer = static_cast<VulkanGraphicsBuffer*>(buffer.getNativeBufferPtr());
 
-    const auto bufferInfo = vk::DescriptorBufferInfo {
-        .buffer = vk_buffer->buffer,
-        .offset = 0,
-        .range = static_cast<vk::DeviceSize>(buffer.getSize())
-    };
-    const auto writeDescriptorSet = vk::WriteDescriptorSet{
-        .dstSet = vk_material->descriptorSets[0],
-        .dstBinding = index,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = vk::DescriptorType::eUniformBuffer,
-        .pBufferInfo = &bufferInfo
-    };
-    _logicalDevice.updateDescriptorSets({writeDescriptorSet}, {});
+    GetUniformBinding(*vk_material, index).perDraw = false;
+    vk_material->constantBuffers[index] = vk_buffer;
+    _invalidateDescriptor(*vk_material, index);
+}
+
+// The descriptor covers one block at the start of the ring, the draw moves it with its offset.
+void VulkanGfxDevice::SetPerDrawConstantBuffer(void* material, uint32_t index) {
+    auto vk_material = static_cast<VulkanMaterial*>(material);
+
+    auto& binding = GetUniformBinding(*vk_material, index);
+    binding.perDraw = true;
+    _perDrawRange = std::max(_perDrawRange, binding.size);
+    vk_material->constantBuffers.erase(index);
+    _invalidateDescriptor(*vk_material, index);
+}
+
+// Any per-draw binding may read the constants, so each allocation covers the largest range.
+// The ring does not grow, the descriptors point into it.
+auto VulkanGfxDevice::AllocatePerDrawConstants(std::span<const std::byte> bytes) -> tl::optional<uint32_t> {
+    return _uniformRing->allocate(bytes, _perDrawRange);
 }
 
 void VulkanGfxDevice::SetTexture(void* material, uint32_t index, const Texture2D &texture) {
     auto vk_material = static_cast<VulkanMaterial*>(material);
-    const auto imageInfo = vk::DescriptorImageInfo{
-        .sampler = texture.getSampler(),
-        .imageView = texture.getImageView(),
-        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+    auto vk_texture = static_cast<VulkanTexture*>(texture.getNativeTexturePtr());
+
+    vk_material->textures[index] = vk_texture;
+    _invalidateDescriptor(*vk_material, index);
+}
+
+// Sets of a material already drawn may be in a frame in flight, or bound in the frame being
+// recorded. Each is written at the start of its own frame instead, so a change shows from the
+// next frame on.
+void VulkanGfxDevice::_invalidateDescriptor(VulkanMaterial& material, uint32_t index) {
+    if (!material.live) {
+        for (const auto set : material.descriptorSets) {
+            _writeDescriptor(material, set, index);
+        }
+        return;
+    }
+    material.pendingWrites[index] = (1u << _frameCount) - 1;
+}
+
+void VulkanGfxDevice::_writePendingDescriptors() {
+    const auto bit = 1u << _frameIndex;
+    for (const auto material : _materials) {
+        material->live = true;
+        material->descriptorSet = material->descriptorSets[_frameIndex];
+        for (auto it = material->pendingWrites.begin(); it != material->pendingWrites.end();) {
+            if (it->second & bit) {
+                _writeDescriptor(*material, material->descriptorSet, it->first);
+                it->second &= ~bit;
+            }
+            it = it->second == 0 ? material->pendingWrites.erase(it) : std::next(it);
+        }
+    }
+}
+
+// Bindings whose resource was destroyed are left as they are, the material must not be drawn
+// until they are set again.
+void VulkanGfxDevice::_writeDescriptor(const VulkanMaterial& material, vk::DescriptorSet set, uint32_t index) {
+    if (const auto it = material.textures.find(index); it != material.textures.end()) {
+        const auto imageInfo = vk::DescriptorImageInfo{
+            .sampler = it->second->sampler,
+            .imageView = it->second->imageView,
+            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+        };
+        const auto writeDescriptorSet = vk::WriteDescriptorSet{
+            .dstSet = set,
+            .dstBinding = index,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+            .pImageInfo = &imageInfo
+        };
+        _logicalDevice.updateDescriptorSets({writeDescriptorSet}, {});
+        return;
+    }
+
+    const auto binding = std::ranges::find(material.uniformBindings, index, &VulkanUniformBinding::binding);
+    if (binding == material.uniformBindings.end()) {
+        return;
+    }
+
+    auto bufferInfo = vk::DescriptorBufferInfo{
+        .buffer = _uniformRing->getBuffer(),
+        .offset = 0,
+        .range = binding->size
     };
+    if (const auto it = material.constantBuffers.find(index); it != material.constantBuffers.end()) {
+        bufferInfo = vk::DescriptorBufferInfo{
+            .buffer = it->second->buffer,
+            .offset = it->second->offset,
+            .range = std::min(binding->size, it->second->size)
+        };
+    } else if (!binding->perDraw) {
+        return;
+    }
+
     const auto writeDescriptorSet = vk::WriteDescriptorSet{
-        .dstSet = vk_material->descriptorSets[0],
+        .dstSet = set,
         .dstBinding = index,
         .dstArrayElement = 0,
         .descriptorCount = 1,
-        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .pImageInfo = &imageInfo
+        .descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+        .pBufferInfo = &bufferInfo
     };
     _logicalDevice.updateDescriptorSets({writeDescriptorSet}, {});
 }
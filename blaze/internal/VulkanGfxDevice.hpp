@@ -4,15 +4,56 @@
 
 #include <Graphics.hpp>
 #include <GraphicsBuffer.hpp>
-
+#include <MemoryStatistics.hpp>
+#include <SamplerDescriptor.hpp>
+
+#include <map>
+#include <array>
+#include <string>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 #include <vk_mem_alloc.h>
+#include <tl/optional.hpp>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_beta.h>
 
 struct Resource;
+struct VulkanSamplerCache;
+struct VulkanStagingRing;
+struct VulkanFrameAllocator;
+struct VulkanGraphicsBuffer;
+struct VulkanBufferPool;
+struct VulkanUniformRing;
+struct VulkanTimeline;
+struct VulkanTexture;
+struct VulkanMaterial;
 
 struct VulkanGfxDevice {
 public:
+    // Large enough for a few full-screen RGBA8 uploads per frame, bigger ones take a blocking path.
+    static constexpr vk::DeviceSize kStagingRingCapacity = 32 * 1024 * 1024;
+    // Vertex and index buffers up to half of this share blocks.
+    static constexpr vk::DeviceSize kBufferPoolBlockSize = 16 * 1024 * 1024;
+    // Per frame in flight, the ImGui geometry of a busy frame takes a few hundred kilobytes.
+    static constexpr vk::DeviceSize kFrameAllocatorCapacity = 4 * 1024 * 1024;
+    // Per frame in flight, four thousand draws with 256 bytes of constants each.
+    static constexpr vk::DeviceSize kUniformRingCapacity = 1024 * 1024;
+    // A defragmentation pass moves at most this much at the start of a frame, the next pass
+    // starts once that frame has retired.
+    static constexpr uint32_t kDefragmentationMaxMovesPerPass = 16;
+    static constexpr vk::DeviceSize kDefragmentationMaxBytesPerPass = 32 * 1024 * 1024;
+    // Every this many frames the device-local heaps are checked, defragmentation starts when
+    // a quarter of their blocks and at least kDefragmentationMinUnusedBytes lie unused.
+    static constexpr uint32_t kDefragmentationCheckInterval = 600;
+    static constexpr vk::DeviceSize kDefragmentationMinUnusedBytes = 32 * 1024 * 1024;
+    // On a discrete GPU, a host-visible device-local heap larger than the legacy 256 MiB window
+    // is Resizable BAR. Buffers the CPU writes are placed there, up to half of the heap unless
+    // configured. Pooled buffers count whole kBufferPoolBlockSize blocks against that budget.
+    static constexpr vk::DeviceSize kResizableBarMinHeapSize = 256 * 1024 * 1024;
+
     explicit VulkanGfxDevice(Display& display);
     ~VulkanGfxDevice();
 
@@ -28,15 +69,39 @@ public:
     [[nodiscard]] auto getGraphicsQueue() const -> vk::Queue {
         return _graphicsQueue;
     }
+    [[nodiscard]] auto getTransferQueue() const -> vk::Queue {
+        return _transferQueue;
+    }
     [[nodiscard]] auto getPresentFamily() const -> uint32_t {
         return _presentFamily;
     }
     [[nodiscard]] auto getGraphicsFamily() const -> uint32_t {
         return _graphicsFamily;
     }
+    [[nodiscard]] auto getTransferFamily() const -> uint32_t {
+        return _transferFamily;
+    }
     [[nodiscard]] auto getSurface() const -> vk::SurfaceKHR {
         return _surface;
     }
+    [[nodiscard]] auto getStagingRing() const -> VulkanStagingRing& {
+        return *_stagingRing;
+    }
+    [[nodiscard]] auto getSamplerCache() const -> VulkanSamplerCache& {
+        return *_samplerCache;
+    }
+    [[nodiscard]] auto getFrameAllocator() const -> VulkanFrameAllocator& {
+        return *_frameAllocator;
+    }
+    [[nodiscard]] auto getUniformRing() const -> VulkanUniformRing& {
+        return *_uniformRing;
+    }
+    [[nodiscard]] auto getGraphicsTimeline() const -> VulkanTimeline& {
+        return *_graphicsTimeline;
+    }
+    [[nodiscard]] auto getTransferTimeline() const -> VulkanTimeline& {
+        return *_transferTimeline;
+    }
 
 private:
     void _createInstance(Display& display);
@@ -44,18 +109,53 @@ private:
     void _selectPhysicalDevice();
     void _createLogicalDevice();
     void _createMemoryResource();
+    void _createTimelines();
+    void _createStagingRing();
+    void _createSamplerCache();
+    void _stageBuffer(VulkanGraphicsBuffer& buffer, std::span<const std::byte> bytes, size_t offset);
+    auto _getBufferPool(vk::BufferUsageFlags usage, VmaMemoryUsage memoryUsage) -> VulkanBufferPool&;
+    void _deferDestruction(std::function<void()> destroy);
+    void _collectDestructions(bool all);
+    void _trackAllocation(MemoryCategory category, vk::DeviceSize bytes);
+    void _untrackAllocation(MemoryCategory category, vk::DeviceSize bytes);
+    auto _getAllocationSize(const VulkanGraphicsBuffer& buffer) const -> vk::DeviceSize;
+    auto _isFragmented() const -> bool;
+    void _defragment();
+    void _endDefragmentation();
+    void _moveBuffer(vk::CommandBuffer cmd, VulkanGraphicsBuffer& buffer, VmaAllocation allocation);
+    void _moveTexture(vk::CommandBuffer cmd, VulkanTexture& texture, VmaAllocation allocation);
+    void _rebindMovedResources(const std::unordered_set<const void*>& moved);
+    void _invalidateDescriptor(VulkanMaterial& material, uint32_t index);
+    void _writePendingDescriptors();
+    void _writeDescriptor(const VulkanMaterial& material, vk::DescriptorSet set, uint32_t index);
 
 public:
+    // Waits for everything submitted to the graphics and transfer queues.
     void WaitIdle();
-
-    auto CreateGPUFence() -> void*;
-    void DestroyGPUFence(void* fence);
-    void WaitOnGPUFence(void* fence);
-    void ExecuteCommandBuffer(const CommandBuffer& cmd, void* fence);
-
-    auto CreateBuffer(GraphicsBuffer::Target target, int size) -> void*;
+    void FlushUploads();
+    // The swapchain decides the number of frames in flight, BeginFrame follows the wait for the
+    // frame's previous submission and EndFrame follows its new one.
+    void SetFrameCount(uint32_t frameCount);
+    void BeginFrame(uint32_t frameIndex);
+    void EndFrame();
+    // Summed over the device-local heaps, as VMA estimates it.
+    auto GetDeviceLocalBudget() const -> VmaBudget;
+    auto GetMemoryStatistics() const -> MemoryStatistics;
+    // Starts defragmenting at the next frame instead of waiting for the periodic check.
+    void RequestDefragmentation();
+    auto BuildMemoryStatisticsString() const -> std::string;
+    // Zero without Resizable BAR, larger values are clamped to the heap.
+    void SetResizableBarBudget(vk::DeviceSize bytes);
+    auto GetResizableBarBudget() const -> vk::DeviceSize;
+
+    void WaitOnGPUFence(uint64_t value);
+    // Returns the value the submission signals on the graphics timeline.
+    auto ExecuteCommandBuffer(const CommandBuffer& cmd) -> uint64_t;
+
+    auto CreateBuffer(GraphicsBuffer::Target target, int size, GraphicsBuffer::Usage usage, int stride) -> void*;
     void DestroyBuffer(void* buffer);
     void UpdateBuffer(void* buffer, std::span<const std::byte> bytes, size_t offset);
+    auto MapBuffer(void* buffer) -> std::span<std::byte>;
 
     auto CreateCommandPool() -> void*;
     void DestroyCommandPool(void* pool);
@@ -63,13 +163,18 @@ public:
     auto AllocateCommandBuffer(void* pool) -> void*;
     void FreeCommandBuffer(void* pool, void* cmd);
 
-    auto CreateTexture(glm::u32 width, glm::u32 height, vk::Format format) -> void*;
+    auto SupportsLinearBlit(vk::Format format) const -> bool;
+    auto SupportsTextureCompressionBC() const -> bool;
+    auto CreateTexture(glm::u32 width, glm::u32 height, vk::Format format, glm::u32 mipLevels, const SamplerDescriptor& sampler) -> void*;
     auto CreateTexture(VkImage image, VkImageView imageView, VkSampler sampler, VmaAllocation allocation) -> void*;
     void DestroyTexture(void* texture);
+    void SetSampler(void* texture, const SamplerDescriptor& sampler);
 
     auto CreateMaterial(Resource const& resource) -> void*;
     void DestroyMaterial(void* material);
     void SetConstantBuffer(void* material, uint32_t index, GraphicsBuffer const& buffer);
+    void SetPerDrawConstantBuffer(void* material, uint32_t index);
+    auto AllocatePerDrawConstants(std::span<const std::byte> bytes) -> tl::optional<uint32_t>;
     void SetTexture(void* material, uint32_t index, const Texture2D &texture);
 
     void SetRenderPass(vk::RenderPass pass);
@@ -88,8 +193,50 @@ private:
 
     uint32_t _graphicsFamily;
     uint32_t _presentFamily;
+    uint32_t _transferFamily;
 
     vk::Queue _presentQueue;
     vk::Queue _graphicsQueue;
+    vk::Queue _transferQueue;
     vk::RenderPass _renderPass;
+
+    std::unique_ptr<VulkanTimeline> _graphicsTimeline;
+    std::unique_ptr<VulkanTimeline> _transferTimeline;
+    std::unique_ptr<VulkanStagingRing> _stagingRing;
+    std::unique_ptr<VulkanSamplerCache> _samplerCache;
+    std::unique_ptr<VulkanFrameAllocator> _frameAllocator;
+    std::unique_ptr<VulkanUniformRing> _uniformRing;
+    uint32_t _frameCount = 1;
+    uint32_t _frameIndex = 0;
+    vk::DeviceSize _perDrawRange = 0;
+    std::map<std::pair<VkBufferUsageFlags, VmaMemoryUsage>, std::unique_ptr<VulkanBufferPool>> _bufferPools;
+
+    // Resources wait for the graphics timeline to reach the value the next frame submission
+    // signals, zero until that submission has happened. The upload batch goes out ahead of the
+    // frame and signals a lower value, too early for draws recorded before the release.
+    struct DeferredDestruction {
+        uint64_t value;
+        std::function<void()> destroy;
+    };
+
+    std::deque<DeferredDestruction> _deferredDestructions;
+
+    bool _hasMemoryBudget = false;
+    bool _hasTextureCompressionBC = false;
+    vk::DeviceSize _resizableBarHeapSize = 0;
+    vk::DeviceSize _resizableBarBudget = 0;
+    vk::DeviceSize _resizableBarUsage = 0;
+    std::array<MemoryCategoryStatistics, kMemoryCategoryNames.size()> _memoryCategories{};
+
+    // Static buffers outside the pools and sampled textures, keyed by allocation for the moves
+    // VMA proposes. Everything else holds on to its memory, pooled vertex and index buffers
+    // included: their blocks are not compacted, a block only goes once all its ranges are freed.
+    std::unordered_map<VmaAllocation, VulkanGraphicsBuffer*> _movableBuffers;
+    std::unordered_map<VmaAllocation, VulkanTexture*> _movableTextures;
+    std::unordered_set<VulkanMaterial*> _materials;
+
+    VmaDefragmentationContext _defragmentation = nullptr;
+    bool _defragmentationRequested = false;
+    bool _defragmentationPassPending = false;
+    uint32_t _framesSinceDefragmentationCheck = 0;
 };
\ No newline at end of file
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "VulkanBufferPool.hpp"
+
+#include <MemoryStatistics.hpp>
+
+#include <cstddef>
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 
@@ -7,4 +12,20 @@ struct VulkanGraphicsBuffer {
     vk::Buffer buffer{};
     VmaAllocation allocation{};
     VmaAllocationInfo allocationInfo{};
+    vk::BufferUsageFlags usage{};
+    // Mapped for the lifetime of the buffer, null in device-only memory.
+    std::byte* data{};
+    // Static buffers in the Resizable BAR heap are mapped too but not handed out, they are
+    // written through it until a submission could have read them and staged after that.
+    std::byte* hostData{};
+    uint64_t createdAt{};
+    bool resizableBar{};
+    // Where the buffer starts in the VkBuffer, which it shares with others when it comes from
+    // a pool. The offset is a multiple of the stride.
+    vk::DeviceSize offset{};
+    vk::DeviceSize size{};
+    vk::DeviceSize stride{};
+    VulkanBufferPool* pool{};
+    VulkanBufferRange range{};
+    MemoryCategory category{};
 };
\ No newline at end of file
@@ -1,17 +1,41 @@
 #pragma once
 
+#include <map>
 #include <vector>
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 
+struct VulkanTexture;
+struct VulkanGraphicsBuffer;
+
+// Uniform blocks are bound as dynamic uniform buffers, in binding order to match the dynamic
+// offsets. Per-draw bindings read from the uniform ring at the offset given to the draw.
+struct VulkanUniformBinding {
+    uint32_t binding;
+    vk::DeviceSize size;
+    bool perDraw;
+};
+
 struct VulkanMaterial {
     vk::Pipeline pipeline;
     vk::PipelineLayout pipelineLayout;
     std::vector<uint32_t> dynamicOffsets;
+    std::vector<VulkanUniformBinding> uniformBindings;
 
     vk::DescriptorPool descriptorPool;
     vk::DescriptorSetLayout descriptorSetLayout;
+    // One set per frame in flight, each written only once its frame's previous submission is
+    // done. descriptorSet is the one the current frame binds.
     std::vector<vk::DescriptorSet> descriptorSets;
+    vk::DescriptorSet descriptorSet;
+    // Bindings changed since their sets were written, with a bit for each frame still to do.
+    std::map<uint32_t, uint32_t> pendingWrites;
+    // Sets of a material that has not been through BeginFrame are in no submission yet.
+    bool live = false;
 
     std::vector<vk::Sampler> samplers;
+
+    // What each binding was last set to, written again when defragmentation moves it.
+    std::map<uint32_t, const VulkanTexture*> textures;
+    std::map<uint32_t, const VulkanGraphicsBuffer*> constantBuffers;
 };
\ No newline at end of file
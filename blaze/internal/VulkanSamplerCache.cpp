@@ -0,0 +1,66 @@
+#include "VulkanSamplerCache.hpp"
+
+#include <bit>
+#include <algorithm>
+
+// Packs the whole descriptor into one key, the bias goes in by its bit pattern.
+static auto GetSamplerKey(const SamplerDescriptor& descriptor) -> uint64_t {
+    return static_cast<uint64_t>(descriptor.filterMode)
+        | static_cast<uint64_t>(descriptor.wrapMode) << 4
+        | static_cast<uint64_t>(std::min(descriptor.anisoLevel, 255u)) << 8
+        | static_cast<uint64_t>(std::bit_cast<uint32_t>(descriptor.mipMapBias)) << 32;
+}
+
+static constexpr auto GetAddressMode(TextureWrapMode mode) -> vk::SamplerAddressMode {
+    switch (mode) {
+        case TextureWrapMode::Repeat:
+            return vk::SamplerAddressMode::eRepeat;
+        case TextureWrapMode::Clamp:
+            return vk::SamplerAddressMode::eClampToEdge;
+        case TextureWrapMode::Mirror:
+            return vk::SamplerAddressMode::eMirroredRepeat;
+    }
+    return vk::SamplerAddressMode::eRepeat;
+}
+
+VulkanSamplerCache::VulkanSamplerCache(vk::Device device, float maxAnisotropy) : _device(device), _maxAnisotropy(maxAnisotropy) {}
+
+VulkanSamplerCache::~VulkanSamplerCache() {
+    for (auto& [key, sampler] : _samplers) {
+        _device.destroySampler(sampler);
+    }
+}
+
+auto VulkanSamplerCache::get(const SamplerDescriptor& descriptor) -> vk::Sampler {
+    const auto key = GetSamplerKey(descriptor);
+    if (auto it = _samplers.find(key); it != _samplers.end()) {
+        return it->second;
+    }
+
+    const auto filter = descriptor.filterMode == FilterMode::Point ? vk::Filter::eNearest : vk::Filter::eLinear;
+    const auto mipmapMode = descriptor.filterMode == FilterMode::Trilinear ? vk::SamplerMipmapMode::eLinear : vk::SamplerMipmapMode::eNearest;
+    const auto addressMode = GetAddressMode(descriptor.wrapMode);
+    const auto anisotropy = std::min(static_cast<float>(descriptor.anisoLevel), _maxAnisotropy);
+
+    const auto sampler = _device.createSampler(vk::SamplerCreateInfo{
+        .magFilter = filter,
+        .minFilter = filter,
+        .mipmapMode = mipmapMode,
+        .addressModeU = addressMode,
+        .addressModeV = addressMode,
+        .addressModeW = addressMode,
+        .mipLodBias = descriptor.mipMapBias,
+        .anisotropyEnable = anisotropy > 1.0f ? VK_TRUE : VK_FALSE,
+        .maxAnisotropy = std::max(anisotropy, 1.0f),
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE
+    });
+    _samplers.emplace(key, sampler);
+    return sampler;
+}
+
+auto VulkanSamplerCache::contains(vk::Sampler sampler) const -> bool {
+    return std::ranges::any_of(_samplers, [sampler](const auto& entry) {
+        return entry.second == sampler;
+    });
+}
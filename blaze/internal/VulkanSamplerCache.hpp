@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SamplerDescriptor.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vulkan/vulkan.hpp>
+
+// Deduplicates samplers by their state. Samplers live as long as the cache, the number of
+// distinct states an application uses stays far below the driver limits.
+struct VulkanSamplerCache {
+public:
+    VulkanSamplerCache(vk::Device device, float maxAnisotropy);
+    ~VulkanSamplerCache();
+
+    auto get(const SamplerDescriptor& descriptor) -> vk::Sampler;
+    // Whether the sampler came from the cache, anything else belongs to whoever created it.
+    [[nodiscard]] auto contains(vk::Sampler sampler) const -> bool;
+
+    [[nodiscard]] auto size() const -> size_t {
+        return _samplers.size();
+    }
+
+private:
+    vk::Device _device;
+    float _maxAnisotropy;
+    std::unordered_map<uint64_t, vk::Sampler> _samplers;
+};
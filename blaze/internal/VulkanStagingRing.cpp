@@ -0,0 +1,225 @@
+#include "VulkanStagingRing.hpp"
+#include "VulkanTimeline.hpp"
+
+#include <array>
+
+VulkanStagingRing::VulkanStagingRing(vk::Device device, VmaAllocator allocator, vk::Queue graphicsQueue, uint32_t graphicsFamily, VulkanTimeline& graphicsTimeline, vk::Queue transferQueue, uint32_t transferFamily, VulkanTimeline& transferTimeline, vk::DeviceSize capacity)
+    : _device(device)
+    , _allocator(allocator)
+    , _graphicsQueue(graphicsQueue)
+    , _transferQueue(transferQueue)
+    , _graphicsFamily(graphicsFamily)
+    , _transferFamily(transferFamily)
+    , _graphicsTimeline(&graphicsTimeline)
+    , _transferTimeline(&transferTimeline)
+    , _capacity(capacity) {
+    // Both families read the staging memory, concurrent sharing spares the buffer barriers.
+    const auto families = std::array{graphicsFamily, transferFamily};
+
+    auto bufferCreateInfo = vk::BufferCreateInfo {
+        .size = capacity,
+        .usage = vk::BufferUsageFlagBits::eTransferSrc
+    };
+    if (hasTransferQueue()) {
+        bufferCreateInfo.setSharingMode(vk::SharingMode::eConcurrent);
+        bufferCreateInfo.setQueueFamilyIndices(families);
+    }
+
+    const auto allocCreateInfo = VmaAllocationCreateInfo{
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_CPU_ONLY
+    };
+
+    const auto vkBufferCreateInfo = static_cast<VkBufferCreateInfo>(bufferCreateInfo);
+
+    VkBuffer buffer;
+    VmaAllocationInfo allocationInfo;
+    vmaCreateBuffer(_allocator, &vkBufferCreateInfo, &allocCreateInfo, &buffer, &_allocation, &allocationInfo);
+
+    _buffer = buffer;
+    _data = static_cast<std::byte*>(allocationInfo.pMappedData);
+
+    _graphics.pool = _device.createCommandPool(vk::CommandPoolCreateInfo{
+        .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+        .queueFamilyIndex = graphicsFamily
+    });
+    if (hasTransferQueue()) {
+        _transfer.pool = _device.createCommandPool(vk::CommandPoolCreateInfo{
+            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+            .queueFamilyIndex = transferFamily
+        });
+    }
+}
+
+VulkanStagingRing::~VulkanStagingRing() {
+    while (!_batches.empty()) {
+        _retire(true);
+    }
+
+    if (_transfer.pool) {
+        _device.destroyCommandPool(_transfer.pool);
+    }
+    _device.destroyCommandPool(_graphics.pool);
+    vmaDestroyBuffer(_allocator, _buffer, _allocation);
+}
+
+auto VulkanStagingRing::allocate(vk::DeviceSize size, vk::DeviceSize alignment) -> tl::optional<VulkanStagingAllocation> {
+    if (size > _capacity) {
+        return tl::nullopt;
+    }
+
+    _retire(false);
+    while (true) {
+        if (const auto offset = _tryAllocate(size, alignment)) {
+            return VulkanStagingAllocation{
+                .buffer = _buffer,
+                .offset = *offset,
+                .data = _data + *offset
+            };
+        }
+        if (_batches.empty() && _pending == 0) {
+            return tl::nullopt;
+        }
+        if (_batches.empty()) {
+            flush();
+        }
+        _retire(true);
+    }
+}
+
+auto VulkanStagingRing::getGraphicsCommandBuffer() -> vk::CommandBuffer {
+    return _begin(_graphics);
+}
+
+auto VulkanStagingRing::getTransferCommandBuffer() -> vk::CommandBuffer {
+    return hasTransferQueue() ? _begin(_transfer) : _begin(_graphics);
+}
+
+// The transfer side signals its timeline and the graphics side waits for that value at the
+// transfer stage, where the ownership acquires start. The graphics submission always happens,
+// its value on the graphics timeline retires the whole batch. Reserved bytes without recorded
+// copies are submitted too, otherwise a full ring would have no batch to wait for.
+void VulkanStagingRing::flush() {
+    if (!_graphics.recording && !_transfer.recording && _pending == 0) {
+        return;
+    }
+
+    auto transferValue = uint64_t{};
+    auto transferCmd = vk::CommandBuffer{};
+    if (_transfer.recording) {
+        transferValue = _transferTimeline->next();
+        transferCmd = _transfer.cmd;
+        transferCmd.end();
+
+        const auto transferSemaphore = _transferTimeline->getSemaphore();
+        const auto transferTimelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}
+            .setSignalSemaphoreValues(transferValue);
+        const auto transferSubmitInfo = vk::SubmitInfo{
+            .pNext = &transferTimelineSubmitInfo
+        }.setCommandBuffers(transferCmd).setSignalSemaphores(transferSemaphore);
+
+        _transferQueue.submit(1, &transferSubmitInfo, nullptr);
+        _transfer.recording = false;
+    }
+
+    auto graphicsCmd = _begin(_graphics);
+    graphicsCmd.end();
+
+    const auto value = _graphicsTimeline->next();
+    const auto semaphore = _graphicsTimeline->getSemaphore();
+    const auto waitSemaphore = _transferTimeline->getSemaphore();
+    const auto waitStage = vk::PipelineStageFlags{vk::PipelineStageFlagBits::eTransfer};
+
+    auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}
+        .setSignalSemaphoreValues(value);
+    auto submitInfo = vk::SubmitInfo{
+        .pNext = &timelineSubmitInfo
+    }.setCommandBuffers(graphicsCmd).setSignalSemaphores(semaphore);
+    if (transferCmd) {
+        timelineSubmitInfo.setWaitSemaphoreValues(transferValue);
+        submitInfo.setWaitSemaphores(waitSemaphore);
+        submitInfo.setWaitDstStageMask(waitStage);
+    }
+
+    _graphicsQueue.submit(1, &submitInfo, nullptr);
+    _graphics.recording = false;
+
+    _batches.emplace_back(Batch{
+        .value = value,
+        .graphicsCmd = graphicsCmd,
+        .transferCmd = transferCmd,
+        .size = _pending,
+        .end = _head
+    });
+    _pending = 0;
+}
+
+auto VulkanStagingRing::_begin(Recorder& recorder) -> vk::CommandBuffer {
+    if (!recorder.recording) {
+        if (recorder.freeCommandBuffers.empty()) {
+            recorder.cmd = _device.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+                .commandPool = recorder.pool,
+                .level = vk::CommandBufferLevel::ePrimary,
+                .commandBufferCount = 1
+            }).front();
+        } else {
+            recorder.cmd = recorder.freeCommandBuffers.back();
+            recorder.freeCommandBuffers.pop_back();
+        }
+        recorder.cmd.begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+        recorder.recording = true;
+    }
+    return recorder.cmd;
+}
+
+// The wasted tail of the buffer on wrap-around is charged to the allocation that wrapped, so
+// retiring a batch always frees exactly the bytes it consumed.
+auto VulkanStagingRing::_tryAllocate(vk::DeviceSize size, vk::DeviceSize alignment) -> tl::optional<vk::DeviceSize> {
+    if (_used == 0) {
+        _head = 0;
+        _tail = 0;
+    } else if (_head == _tail) {
+        return tl::nullopt;
+    }
+
+    const auto offset = (_head + alignment - 1) / alignment * alignment;
+    const auto limit = _head >= _tail ? _capacity : _tail;
+
+    auto consumed = vk::DeviceSize{};
+    auto start = offset;
+    if (offset + size <= limit) {
+        consumed = offset + size - _head;
+    } else if (_head >= _tail && size <= _tail) {
+        consumed = _capacity - _head + size;
+        start = 0;
+    } else {
+        return tl::nullopt;
+    }
+
+    _head = (start + size) % _capacity;
+    _used += consumed;
+    _pending += consumed;
+    return start;
+}
+
+void VulkanStagingRing::_retire(bool wait) {
+    while (!_batches.empty()) {
+        auto& batch = _batches.front();
+        if (wait) {
+            _graphicsTimeline->wait(batch.value);
+        } else if (!_graphicsTimeline->isComplete(batch.value)) {
+            break;
+        }
+
+        _used -= batch.size;
+        _tail = batch.end;
+        _graphics.freeCommandBuffers.emplace_back(batch.graphicsCmd);
+        if (batch.transferCmd) {
+            _transfer.freeCommandBuffers.emplace_back(batch.transferCmd);
+        }
+        _batches.pop_front();
+
+        // Waiting for the oldest batch is enough to make room, the rest are polled next time.
+        wait = false;
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstddef>
+#include <vk_mem_alloc.h>
+#include <tl/optional.hpp>
+#include <vulkan/vulkan.hpp>
+
+struct VulkanTimeline;
+
+struct VulkanStagingAllocation {
+    vk::Buffer buffer{};
+    vk::DeviceSize offset{};
+    std::byte* data{};
+};
+
+// A persistently mapped staging buffer used as a ring. Uploads reserve space and record their
+// copies into shared command buffers, which flush() submits as one batch. The space of a batch
+// is reclaimed once the graphics timeline has reached the value its submission signaled.
+//
+// With a dedicated transfer family the batch is split in two: copies recorded on the transfer
+// side signal the transfer timeline, and the graphics side waits on that value before its
+// queue family ownership acquires. Without one both command buffers are the same graphics one.
+struct VulkanStagingRing {
+public:
+    VulkanStagingRing(vk::Device device, VmaAllocator allocator, vk::Queue graphicsQueue, uint32_t graphicsFamily, VulkanTimeline& graphicsTimeline, vk::Queue transferQueue, uint32_t transferFamily, VulkanTimeline& transferTimeline, vk::DeviceSize capacity);
+    ~VulkanStagingRing();
+
+    // Returns nullopt only if the request can never fit. A full ring first submits the pending
+    // uploads and then waits for the oldest batch.
+    auto allocate(vk::DeviceSize size, vk::DeviceSize alignment) -> tl::optional<VulkanStagingAllocation>;
+    auto getGraphicsCommandBuffer() -> vk::CommandBuffer;
+    auto getTransferCommandBuffer() -> vk::CommandBuffer;
+    void flush();
+
+    [[nodiscard]] auto getCapacity() const -> vk::DeviceSize {
+        return _capacity;
+    }
+    [[nodiscard]] auto hasTransferQueue() const -> bool {
+        return _transferFamily != _graphicsFamily;
+    }
+    [[nodiscard]] auto getGraphicsFamily() const -> uint32_t {
+        return _graphicsFamily;
+    }
+    [[nodiscard]] auto getTransferFamily() const -> uint32_t {
+        return _transferFamily;
+    }
+
+private:
+    struct Batch {
+        uint64_t value;
+        vk::CommandBuffer graphicsCmd;
+        vk::CommandBuffer transferCmd;
+        vk::DeviceSize size;
+        vk::DeviceSize end;
+    };
+
+    struct Recorder {
+        vk::CommandPool pool;
+        vk::CommandBuffer cmd;
+        bool recording = false;
+        std::vector<vk::CommandBuffer> freeCommandBuffers;
+    };
+
+    auto _tryAllocate(vk::DeviceSize size, vk::DeviceSize alignment) -> tl::optional<vk::DeviceSize>;
+    void _retire(bool wait);
+    auto _begin(Recorder& recorder) -> vk::CommandBuffer;
+
+    vk::Device _device;
+    VmaAllocator _allocator;
+    vk::Queue _graphicsQueue;
+    vk::Queue _transferQueue;
+    uint32_t _graphicsFamily;
+    uint32_t _transferFamily;
+    VulkanTimeline* _graphicsTimeline;
+    VulkanTimeline* _transferTimeline;
+
+    vk::Buffer _buffer;
+    VmaAllocation _allocation;
+    std::byte* _data;
+
+    vk::DeviceSize _capacity;
+    vk::DeviceSize _head = 0;
+    vk::DeviceSize _tail = 0;
+    vk::DeviceSize _used = 0;
+    vk::DeviceSize _pending = 0;
+
+    Recorder _graphics;
+    Recorder _transfer;
+
+    std::deque<Batch> _batches;
+};
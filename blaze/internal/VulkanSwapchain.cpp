@@ -1,11 +1,14 @@
 #include "VulkanSwapchain.hpp"
 #include "VulkanGfxDevice.hpp"
+#include "VulkanTimeline.hpp"
 
 #include <Texture.hpp>
 #include <Graphics.hpp>
 #include <CommandPool.hpp>
 #include <CommandBuffer.hpp>
 
+#include <algorithm>
+
 static auto SelectSurfaceExtent(vk::Extent2D extent, const vk::SurfaceCapabilitiesKHR &surface_capabilities) -> vk::Extent2D {
     if (surface_capabilities.currentExtent.width != std::numeric_limits<glm::u32>::max()) {
         return surface_capabilities.currentExtent;
@@ -87,6 +90,7 @@ VulkanSwapchain::VulkanSwapchain(VulkanGfxDevice& gfx)
     , _surface(gfx.getSurface())
     , _presentQueue(gfx.getPresentQueue())
     , _graphicsQueue(gfx.getGraphicsQueue())
+    , _timeline(&gfx.getGraphicsTimeline())
     , _presentFamily(gfx.getPresentFamily())
     , _graphicsFamily(gfx.getGraphicsFamily())
     , _depthFormat(GetSupportedDepthFormat(_physicalDevice))
@@ -97,7 +101,11 @@ VulkanSwapchain::VulkanSwapchain(VulkanGfxDevice& gfx)
     _createFrameObjects();
 }
 
+// Presentation signals nothing that could be waited on, only the queue as a whole.
 VulkanSwapchain::~VulkanSwapchain() {
+    _timeline->wait(*std::ranges::max_element(_frameValues));
+    _presentQueue.waitIdle();
+
     for (uint32_t i = 0; i < _frameCount; i++) {
         _logicalDevice.destroyFramebuffer(_framebuffers[i], nullptr);
 
@@ -106,7 +114,6 @@ VulkanSwapchain::~VulkanSwapchain() {
 
         _cmdPools[i].free(_cmdBuffers[i]);
 
-        _logicalDevice.destroyFence(_fences[i], nullptr);
         _logicalDevice.destroySemaphore(_acquiredSemaphores[i], nullptr);
         _logicalDevice.destroySemaphore(_completeSemaphores[i], nullptr);
     }
@@ -237,12 +244,11 @@ void VulkanSwapchain::_createRenderPass() {
 }
 
 void VulkanSwapchain::_createSyncObjects() {
-    _fences.resize(_frameCount);
+    _frameValues.resize(_frameCount, 0);
     _acquiredSemaphores.resize(_frameCount);
     _completeSemaphores.resize(_frameCount);
 
     for (uint32_t i = 0; i < _frameCount; i++) {
-        _fences[i] = _logicalDevice.createFence({.flags = vk::FenceCreateFlagBits::eSignaled});
         _acquiredSemaphores[i] = _logicalDevice.createSemaphore({}, nullptr);
         _completeSemaphores[i] = _logicalDevice.createSemaphore({}, nullptr);
     }
@@ -293,8 +299,7 @@ auto VulkanSwapchain::begin(const glm::vec4& color, float depth, glm::u32 stenci
     static constexpr auto timeout = std::numeric_limits<uint64_t>::max();
     const auto semaphore = _acquiredSemaphores[_frameIndex];
 
-    _logicalDevice.waitForFences(1, &_fences[_frameIndex], true, timeout);
-    _logicalDevice.resetFences(1, &_fences[_frameIndex]);
+    _timeline->wait(_frameValues[_frameIndex]);
     _logicalDevice.acquireNextImageKHR(_swapchain, timeout, semaphore, nullptr, &_swapchainImageIndex);
 
     (*_cmdBuffers[_frameIndex]).begin({ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
@@ -364,13 +369,30 @@ void VulkanSwapchain::present() {
         *_cmdBuffers[_frameIndex]
     };
 
-    const auto submitInfo = vk::SubmitInfo{}
+    // The binary semaphore for presentation ignores its value.
+    const auto value = _timeline->next();
+    const auto signalSemaphores = std::array{
+        completeSemaphore,
+        _timeline->getSemaphore()
+    };
+    const auto signalValues = std::array{
+        uint64_t{0},
+        value
+    };
+
+    const auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}
+        .setSignalSemaphoreValues(signalValues);
+
+    const auto submitInfo = vk::SubmitInfo{
+        .pNext = &timelineSubmitInfo
+    }
         .setWaitDstStageMask(stages)
         .setCommandBuffers(cmdBuffers)
         .setWaitSemaphores(acquiredSemaphore)
-        .setSignalSemaphores(completeSemaphore);
+        .setSignalSemaphores(signalSemaphores);
 
-    _graphicsQueue.submit(1, &submitInfo, _fences[_frameIndex]);
+    _graphicsQueue.submit(1, &submitInfo, nullptr);
+    _frameValues[_frameIndex] = value;
 
     const auto presentInfo = vk::PresentInfoKHR{}
         .setWaitSemaphores(completeSemaphore)
@@ -8,6 +8,7 @@
 struct Texture;
 struct CommandPool;
 struct CommandBuffer;
+struct VulkanTimeline;
 struct VulkanGfxDevice;
 
 struct VulkanSwapchain {
@@ -44,6 +45,7 @@ private:
     vk::SurfaceKHR _surface;
     vk::Queue _presentQueue;
     vk::Queue _graphicsQueue;
+    VulkanTimeline* _timeline;
 
     glm::u32 _presentFamily;
     glm::u32 _graphicsFamily;
@@ -65,7 +67,8 @@ private:
     std::vector<CommandPool> _cmdPools;
     std::vector<CommandBuffer> _cmdBuffers;
 
-    std::vector<vk::Fence> _fences;
+    // The graphics timeline value of each frame's last submission.
+    std::vector<uint64_t> _frameValues;
     std::vector<vk::Semaphore> _acquiredSemaphores;
     std::vector<vk::Semaphore> _completeSemaphores;
 
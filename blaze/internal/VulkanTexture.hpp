@@ -1,11 +1,21 @@
 #pragma once
 
+#include <MemoryStatistics.hpp>
+
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 
 struct VulkanTexture {
     vk::Image image{};
     vk::Sampler sampler{};
+    // Set for a sampler handed in with an existing image, destroyed along with the texture.
+    bool ownsSampler = false;
     vk::ImageView imageView{};
     VmaAllocation allocation{};
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    uint32_t mipLevels = 1;
+    // Enough to create the image again, defragmentation moves it to a new one.
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent{};
+    MemoryCategory category = MemoryCategory::Texture;
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "VulkanTimeline.hpp"
+
+#include <limits>
+
+VulkanTimeline::VulkanTimeline(vk::Device device) : _device(device) {
+    const auto semaphoreTypeCreateInfo = vk::SemaphoreTypeCreateInfo{
+        .semaphoreType = vk::SemaphoreType::eTimeline,
+        .initialValue = 0
+    };
+    _semaphore = _device.createSemaphore(vk::SemaphoreCreateInfo{
+        .pNext = &semaphoreTypeCreateInfo
+    });
+}
+
+VulkanTimeline::~VulkanTimeline() {
+    _device.destroySemaphore(_semaphore);
+}
+
+// The counter is only queried for values past the last one seen complete.
+auto VulkanTimeline::isComplete(uint64_t value) -> bool {
+    if (value > _completed) {
+        _completed = _device.getSemaphoreCounterValue(_semaphore);
+    }
+    return value <= _completed;
+}
+
+void VulkanTimeline::wait(uint64_t value) {
+    if (isComplete(value)) {
+        return;
+    }
+    const auto waitInfo = vk::SemaphoreWaitInfo{}
+        .setSemaphores(_semaphore)
+        .setValues(value);
+    static_cast<void>(_device.waitSemaphores(waitInfo, std::numeric_limits<uint64_t>::max()));
+    _completed = value;
+}
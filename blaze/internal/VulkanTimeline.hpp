@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.hpp>
+
+// A timeline semaphore for one queue. Every submission to the queue signals the next value, so
+// the host and other queues can wait for any earlier submission by its value alone.
+struct VulkanTimeline {
+public:
+    explicit VulkanTimeline(vk::Device device);
+    ~VulkanTimeline();
+
+    // The value for a submission about to be made, submissions must signal them in order.
+    auto next() -> uint64_t {
+        return ++_submitted;
+    }
+    auto isComplete(uint64_t value) -> bool;
+    void wait(uint64_t value);
+
+    [[nodiscard]] auto getSemaphore() const -> vk::Semaphore {
+        return _semaphore;
+    }
+    [[nodiscard]] auto getSubmittedValue() const -> uint64_t {
+        return _submitted;
+    }
+
+private:
+    vk::Device _device;
+    vk::Semaphore _semaphore;
+    uint64_t _submitted = 0;
+    uint64_t _completed = 0;
+};
@@ -0,0 +1,47 @@
+#include "VulkanUniformRing.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+VulkanUniformRing::VulkanUniformRing(VmaAllocator allocator, uint32_t frameCount, vk::DeviceSize capacity, vk::DeviceSize alignment)
+    : _allocator(allocator)
+    , _capacity((capacity + alignment - 1) / alignment * alignment)
+    , _alignment(alignment) {
+    const auto bufferCreateInfo = static_cast<VkBufferCreateInfo>(vk::BufferCreateInfo{
+        .size = _capacity * frameCount,
+        .usage = vk::BufferUsageFlagBits::eUniformBuffer
+    });
+
+    const auto allocCreateInfo = VmaAllocationCreateInfo{
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+        .requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    };
+
+    VkBuffer buffer;
+    VmaAllocationInfo allocationInfo;
+    vmaCreateBuffer(_allocator, &bufferCreateInfo, &allocCreateInfo, &buffer, &_allocation, &allocationInfo);
+
+    _buffer = buffer;
+    _data = static_cast<std::byte*>(allocationInfo.pMappedData);
+}
+
+VulkanUniformRing::~VulkanUniformRing() {
+    vmaDestroyBuffer(_allocator, _buffer, _allocation);
+}
+
+void VulkanUniformRing::beginFrame(uint32_t frameIndex) {
+    _begin = _capacity * frameIndex;
+    _head = _begin;
+}
+
+auto VulkanUniformRing::allocate(std::span<const std::byte> bytes, vk::DeviceSize size) -> tl::optional<uint32_t> {
+    size = std::max<vk::DeviceSize>(size, bytes.size());
+    if (_head + size > _begin + _capacity) {
+        return tl::nullopt;
+    }
+    const auto offset = _head;
+    std::memcpy(_data + offset, bytes.data(), bytes.size());
+    _head = (offset + size + _alignment - 1) / _alignment * _alignment;
+    return static_cast<uint32_t>(offset);
+}
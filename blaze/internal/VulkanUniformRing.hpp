@@ -0,0 +1,36 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+#include <vk_mem_alloc.h>
+#include <tl/optional.hpp>
+#include <vulkan/vulkan.hpp>
+
+// Per-draw constants for dynamic uniform buffer bindings. Unlike the frame allocator the ring
+// never changes its buffer, so a descriptor written once stays valid and every draw only
+// passes its own dynamic offset. Each frame in flight owns a fixed region of the buffer.
+struct VulkanUniformRing {
+public:
+    VulkanUniformRing(VmaAllocator allocator, uint32_t frameCount, vk::DeviceSize capacity, vk::DeviceSize alignment);
+    ~VulkanUniformRing();
+
+    // The caller has waited for the last submission of the frame.
+    void beginFrame(uint32_t frameIndex);
+    // Reserves at least size bytes, descriptors may read past the constants up to their range.
+    // Returns nullopt once the frame's region is full.
+    auto allocate(std::span<const std::byte> bytes, vk::DeviceSize size) -> tl::optional<uint32_t>;
+
+    [[nodiscard]] auto getBuffer() const -> vk::Buffer {
+        return _buffer;
+    }
+
+private:
+    VmaAllocator _allocator;
+    vk::Buffer _buffer;
+    VmaAllocation _allocation;
+    std::byte* _data;
+    vk::DeviceSize _capacity;
+    vk::DeviceSize _alignment;
+    vk::DeviceSize _begin = 0;
+    vk::DeviceSize _head = 0;
+};
@@ -2,6 +2,7 @@
 #include "Blaze.hpp"
 #include "Input.hpp"
 #include "Display.hpp"
+#include "Graphics.hpp"
 #include "UserInterface.hpp"
 
 #include <VulkanGfxDevice.hpp>
@@ -45,7 +46,8 @@ void Blaze::Start(std::function<std::unique_ptr<Application>()> const& fn) {
     device = std::make_unique<VulkanGfxDevice>(*display);
     swapchain = std::make_unique<VulkanSwapchain>(*device);
     device->SetRenderPass(swapchain->getRenderPass());
-    ui = std::make_unique<UserInterface>(swapchain->getFrameCount());
+    device->SetFrameCount(swapchain->getFrameCount());
+    ui = std::make_unique<UserInterface>();
 
     display->OnCharCallback.connect([](char c) {
         ui->AddInputCharacter(c);
@@ -97,6 +99,7 @@ void Blaze::Start(std::function<std::unique_ptr<Application>()> const& fn) {
     app->Init();
 
     auto lastTime = std::chrono::high_resolution_clock::now();
+    auto showMemoryStatistics = false;
     while (!display->shouldClose()) {
         const auto currentTime = std::chrono::high_resolution_clock::now();
         deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
@@ -122,14 +125,28 @@ void Blaze::Start(std::function<std::unique_ptr<Application>()> const& fn) {
 
         app->Update();
 
+        // F3 shows the memory overlay, F4 dumps the statistics to the working directory.
+        if (Input::isKeyDown(KeyCode::eF3)) {
+            showMemoryStatistics = !showMemoryStatistics;
+        }
+        if (Input::isKeyDown(KeyCode::eF4)) {
+            Graphics::DumpMemoryStatistics("memory.json");
+        }
+
         ImGui::NewFrame();
         app->DrawUI();
+        if (showMemoryStatistics) {
+            ui->DrawMemoryStatistics();
+        }
         ImGui::Render();
 
         auto cmd = swapchain->begin(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f, 0);
+        device->BeginFrame(swapchain->getFrameIndex());
         app->Draw(cmd);
         ui->Draw(cmd);
+        device->FlushUploads();
         swapchain->present();
+        device->EndFrame();
     }
     device->WaitIdle();
     app->Destroy();
@@ -5,23 +5,69 @@
 
 #include <VulkanGraphicsBuffer.hpp>
 
-void CommandBuffer::drawMesh(const Mesh &mesh, const Material &material) {
-    auto vk_vertexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeVertexBufferPtr());
-    auto vk_indexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeIndexBufferPtr());
-    auto vk_material = static_cast<VulkanMaterial*>(material.GetNativeHandlePtr());
+// Pooled buffers are bound at the start of their block and addressed through the draw, so
+// meshes that share a block also share the binding.
+static auto GetVertexOffset(const VulkanGraphicsBuffer& buffer) -> int32_t {
+    return static_cast<int32_t>(buffer.offset / buffer.stride);
+}
 
-    auto _cmd = **this;
-    _cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, vk_material->pipeline);
-    _cmd.bindDescriptorSets(
+static auto GetFirstIndex(const VulkanGraphicsBuffer& buffer) -> uint32_t {
+    return static_cast<uint32_t>(buffer.offset / sizeof(uint32_t));
+}
+
+static void BindMaterial(vk::CommandBuffer cmd, const Material& material) {
+    auto vk_material = static_cast<VulkanMaterial*>(material.GetNativeHandlePtr());
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, vk_material->pipeline);
+    cmd.bindDescriptorSets(
         vk::PipelineBindPoint::eGraphics,
         vk_material->pipelineLayout,
         0,
-        vk_material->descriptorSets,
+        vk_material->descriptorSet,
         vk_material->dynamicOffsets
     );
+}
+
+// Rebinding the same set with new dynamic offsets is cheap, the pipeline stays bound.
+static void BindMaterial(vk::CommandBuffer cmd, const Material& material, PerDrawConstants constants) {
+    auto vk_material = static_cast<VulkanMaterial*>(material.GetNativeHandlePtr());
+
+    auto dynamicOffsets = vk_material->dynamicOffsets;
+    for (size_t i = 0; i < dynamicOffsets.size(); ++i) {
+        if (vk_material->uniformBindings[i].perDraw) {
+            dynamicOffsets[i] = constants.offset;
+        }
+    }
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, vk_material->pipeline);
+    cmd.bindDescriptorSets(
+        vk::PipelineBindPoint::eGraphics,
+        vk_material->pipelineLayout,
+        0,
+        vk_material->descriptorSet,
+        dynamicOffsets
+    );
+}
+
+void CommandBuffer::drawMesh(const Mesh &mesh, const Material &material) {
+    auto vk_vertexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeVertexBufferPtr());
+    auto vk_indexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeIndexBufferPtr());
+
+    auto _cmd = **this;
+    BindMaterial(_cmd, material);
+    _cmd.bindVertexBuffers(0, vk_vertexBuffer->buffer, vk::DeviceSize{0});
+    _cmd.bindIndexBuffer(vk_indexBuffer->buffer, 0, vk::IndexType::eUint32);
+    _cmd.drawIndexed(mesh.getIndexCount(), 1, GetFirstIndex(*vk_indexBuffer), GetVertexOffset(*vk_vertexBuffer), 0);
+}
+
+void CommandBuffer::drawMesh(const Mesh& mesh, const Material& material, PerDrawConstants constants) {
+    auto vk_vertexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeVertexBufferPtr());
+    auto vk_indexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeIndexBufferPtr());
+
+    auto _cmd = **this;
+    BindMaterial(_cmd, material, constants);
     _cmd.bindVertexBuffers(0, vk_vertexBuffer->buffer, vk::DeviceSize{0});
     _cmd.bindIndexBuffer(vk_indexBuffer->buffer, 0, vk::IndexType::eUint32);
-    _cmd.drawIndexed(mesh.getIndexCount(), 1, 0, 0, 0);
+    _cmd.drawIndexed(mesh.getIndexCount(), 1, GetFirstIndex(*vk_indexBuffer), GetVertexOffset(*vk_vertexBuffer), 0);
 }
 
 void CommandBuffer::drawMesh(const Mesh& mesh, const Material& material, int submeshIndex) {
@@ -32,20 +78,35 @@ void CommandBuffer::drawMesh(const Mesh& mesh, const Material& material, int sub
 
     auto vk_vertexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeVertexBufferPtr());
     auto vk_indexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeIndexBufferPtr());
-    auto vk_material = static_cast<VulkanMaterial*>(material.GetNativeHandlePtr());
 
     auto _cmd = **this;
-    _cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, vk_material->pipeline);
-    _cmd.bindDescriptorSets(
-        vk::PipelineBindPoint::eGraphics,
-        vk_material->pipelineLayout,
-        0,
-        vk_material->descriptorSets,
-        vk_material->dynamicOffsets
-    );
+    BindMaterial(_cmd, material);
     _cmd.bindVertexBuffers(0, vk_vertexBuffer->buffer, vk::DeviceSize{0});
     _cmd.bindIndexBuffer(vk_indexBuffer->buffer, 0, vk::IndexType::eUint32);
-    _cmd.drawIndexed(submesh.indexCount, 1, submesh.indexOffset, 0, 0);
+    _cmd.drawIndexed(submesh.indexCount, 1, GetFirstIndex(*vk_indexBuffer) + submesh.indexOffset, GetVertexOffset(*vk_vertexBuffer), 0);
+}
+
+// The material is bound once, vertex and index buffers only when the next mesh lives in a
+// different block.
+void CommandBuffer::drawMeshes(std::span<const Mesh* const> meshes, const Material& material) {
+    auto _cmd = **this;
+    BindMaterial(_cmd, material);
+
+    auto boundVertexBuffer = vk::Buffer{};
+    auto boundIndexBuffer = vk::Buffer{};
+    for (const auto mesh : meshes) {
+        auto vk_vertexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh->getNativeVertexBufferPtr());
+        auto vk_indexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh->getNativeIndexBufferPtr());
+        if (vk_vertexBuffer->buffer != boundVertexBuffer) {
+            _cmd.bindVertexBuffers(0, vk_vertexBuffer->buffer, vk::DeviceSize{0});
+            boundVertexBuffer = vk_vertexBuffer->buffer;
+        }
+        if (vk_indexBuffer->buffer != boundIndexBuffer) {
+            _cmd.bindIndexBuffer(vk_indexBuffer->buffer, 0, vk::IndexType::eUint32);
+            boundIndexBuffer = vk_indexBuffer->buffer;
+        }
+        _cmd.drawIndexed(mesh->getIndexCount(), 1, GetFirstIndex(*vk_indexBuffer), GetVertexOffset(*vk_vertexBuffer), 0);
+    }
 }
 
 void CommandBuffer::clearRenderTarget(const glm::vec4& color, float depth, float stencil) {
@@ -1,15 +1,26 @@
 #pragma once
 
+#include <span>
 #include <glm/vec4.hpp>
 #include <vulkan/vulkan.hpp>
 
 struct Mesh;
 struct Material;
+
+// An offset into this frame's uniform ring, see Graphics::AllocatePerDrawConstants.
+struct PerDrawConstants {
+    uint32_t offset;
+};
+
 struct CommandBuffer {
     friend struct CommandPool;
 
     void drawMesh(const Mesh& mesh, const Material& material);
     void drawMesh(const Mesh& mesh, const Material& material, int submeshIndex);
+    // Every binding set with Material::SetPerDrawConstantBuffer reads the given constants.
+    void drawMesh(const Mesh& mesh, const Material& material, PerDrawConstants constants);
+    // For runs of meshes with one material, sorted by buffer to make the most of shared binds.
+    void drawMeshes(std::span<const Mesh* const> meshes, const Material& material);
     void clearRenderTarget(const glm::vec4& color, float depth, float stencil);
     
     auto operator*() const -> vk::CommandBuffer {
@@ -3,22 +3,20 @@
 #include "GraphicsFence.hpp"
 #include "GraphicsBuffer.hpp"
 
+#include <fstream>
+#include <spdlog/spdlog.h>
 #include <VulkanGfxDevice.hpp>
 
 extern auto GetGfxDevice() -> VulkanGfxDevice&;
 
-auto Graphics::CreateGraphicsFence() -> GraphicsFence {
-    GraphicsFence fence;
-    fence.impl.reset(GetGfxDevice().CreateGPUFence());
-    return fence;
-}
-
 void Graphics::WaitOnGraphicsFence(const GraphicsFence& fence) {
-    GetGfxDevice().WaitOnGPUFence(fence.impl.get());
+    GetGfxDevice().WaitOnGPUFence(fence.value);
 }
 
-void Graphics::ExecuteCommandBuffer(const CommandBuffer& cmd, const GraphicsFence& fence) {
-    return GetGfxDevice().ExecuteCommandBuffer(cmd, fence.impl.get());
+auto Graphics::ExecuteCommandBuffer(const CommandBuffer& cmd) -> GraphicsFence {
+    GraphicsFence fence;
+    fence.value = GetGfxDevice().ExecuteCommandBuffer(cmd);
+    return fence;
 }
 
 auto Graphics::CreateCommandPool() -> CommandPool {
@@ -26,3 +24,63 @@ auto Graphics::CreateCommandPool() -> CommandPool {
     pool.impl.reset(GetGfxDevice().CreateCommandPool());
     return pool;
 }
+
+auto Graphics::AllocatePerDrawConstants(std::span<const std::byte> bytes) -> tl::optional<PerDrawConstants> {
+    return GetGfxDevice().AllocatePerDrawConstants(bytes).map([](uint32_t offset) {
+        return PerDrawConstants{
+            .offset = offset
+        };
+    });
+}
+
+auto Graphics::GetMemoryStatistics() -> MemoryStatistics {
+    return GetGfxDevice().GetMemoryStatistics();
+}
+
+auto Graphics::BuildMemoryStatisticsString() -> std::string {
+    return GetGfxDevice().BuildMemoryStatisticsString();
+}
+
+auto Graphics::DumpMemoryStatistics(const std::string& filename) -> bool {
+    auto file = std::ofstream(filename);
+    if (!file) {
+        spdlog::warn("Failed to open {} for the memory statistics", filename);
+        return false;
+    }
+    file << BuildMemoryStatisticsString();
+
+    static constexpr auto MiB = 1024.0 * 1024.0;
+
+    const auto statistics = GetMemoryStatistics();
+    for (size_t heap = 0; heap < statistics.heaps.size(); ++heap) {
+        const auto& stats = statistics.heaps[heap];
+        spdlog::info(
+            "Heap {}{}: {:.1f} of {:.1f} MiB budget, {} allocations in {} blocks, {:.0f}% fragmented",
+            heap,
+            stats.deviceLocal ? " (device local)" : "",
+            static_cast<double>(stats.usage) / MiB,
+            static_cast<double>(stats.budget) / MiB,
+            stats.allocationCount,
+            stats.blockCount,
+            stats.fragmentation() * 100.0f
+        );
+    }
+    for (size_t category = 0; category < statistics.categories.size(); ++category) {
+        const auto& stats = statistics.categories[category];
+        spdlog::info("{}: {} using {:.1f} MiB", kMemoryCategoryNames[category], stats.count, static_cast<double>(stats.bytes) / MiB);
+    }
+    spdlog::info("Memory statistics written to {}", filename);
+    return true;
+}
+
+void Graphics::RequestDefragmentation() {
+    GetGfxDevice().RequestDefragmentation();
+}
+
+void Graphics::SetResizableBarBudget(uint64_t bytes) {
+    GetGfxDevice().SetResizableBarBudget(bytes);
+}
+
+auto Graphics::GetResizableBarBudget() -> uint64_t {
+    return GetGfxDevice().GetResizableBarBudget();
+}
@@ -1,14 +1,43 @@
 #pragma once
 
+#include <span>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <tl/optional.hpp>
+#include "CommandBuffer.hpp"
+#include "MemoryStatistics.hpp"
+
 struct Display;
 struct CommandPool;
 struct GraphicsFence;
 struct CommandBuffer;
 
 struct Graphics {
-    static auto CreateGraphicsFence() -> GraphicsFence;
     static void WaitOnGraphicsFence(const GraphicsFence& fence);
-    static void ExecuteCommandBuffer(const CommandBuffer& cmd, const GraphicsFence& fence);
+    static auto ExecuteCommandBuffer(const CommandBuffer& cmd) -> GraphicsFence;
 
     static auto CreateCommandPool() -> CommandPool;
+
+    // Copies the constants into the uniform ring, valid for draws recorded this frame. Empty
+    // once the frame has used up its part of the ring.
+    static auto AllocatePerDrawConstants(std::span<const std::byte> bytes) -> tl::optional<PerDrawConstants>;
+
+    template <typename T>
+    static auto AllocatePerDrawConstants(const T& constants) -> tl::optional<PerDrawConstants> {
+        return AllocatePerDrawConstants(std::as_bytes(std::span(&constants, 1)));
+    }
+
+    static auto GetMemoryStatistics() -> MemoryStatistics;
+    // Every block and allocation as JSON, in the format of vmaBuildStatsString.
+    static auto BuildMemoryStatisticsString() -> std::string;
+    // Writes the JSON to the file and logs a summary of the heaps and categories.
+    static auto DumpMemoryStatistics(const std::string& filename) -> bool;
+    // Compacts device memory over the next frames, without waiting for the periodic check. Only
+    // textures and static buffers with memory of their own move, pooled meshes stay in place.
+    static void RequestDefragmentation();
+    // How much of the Resizable BAR heap buffers may take to skip the staging copy, half of it by
+    // default and zero without one.
+    static void SetResizableBarBudget(uint64_t bytes);
+    static auto GetResizableBarBudget() -> uint64_t;
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "GraphicsBuffer.hpp"
 
+#include <cassert>
+#include <cstdint>
 #include <VulkanGfxDevice.hpp>
 
 extern auto GetGfxDevice() -> VulkanGfxDevice&;
@@ -8,10 +10,16 @@ void GraphicsBuffer::Dispose::operator()(void *buffer) {
     GetGfxDevice().DestroyBuffer(buffer);
 }
 
-GraphicsBuffer::GraphicsBuffer(Target target, int size) : size(size), target(target) {
-    impl.reset(GetGfxDevice().CreateBuffer(target, size));
+GraphicsBuffer::GraphicsBuffer(Target target, int size, Usage usage, int stride) : size(size), target(target), usage(usage), stride(stride) {
+    assert(target != Target::Vertex || stride > 0);
+    assert(target != Target::Index || stride == sizeof(uint32_t));
+    impl.reset(GetGfxDevice().CreateBuffer(target, size, usage, stride));
 }
 
 void GraphicsBuffer::setData(std::span<const std::byte> bytes, int offset) {
     GetGfxDevice().UpdateBuffer(impl.get(), bytes, offset);
+}
+
+auto GraphicsBuffer::map() const -> std::span<std::byte> {
+    return GetGfxDevice().MapBuffer(impl.get());
 }
\ No newline at end of file
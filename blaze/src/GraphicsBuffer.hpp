@@ -2,6 +2,7 @@
 
 #include <span>
 #include <memory>
+#include <cstddef>
 
 struct GraphicsBuffer {
     friend struct Graphics;
@@ -14,20 +15,46 @@ struct GraphicsBuffer {
         Constant = 1 << 4
     };
 
+    // Dynamic buffers live in host-visible memory and are written in place. Static ones live
+    // in device memory, setData stages the bytes and the copy runs ahead of the next frame.
+    enum class Usage {
+        Dynamic,
+        Static
+    };
+
     GraphicsBuffer() = default;
-    GraphicsBuffer(Target target, int size);
+    // Vertex and index buffers share larger buffers with others of the same usage, placed at a
+    // multiple of the stride, which draws turn into a vertex offset or first index. They need
+    // the element size as the stride, index buffers hold 32-bit indices.
+    GraphicsBuffer(Target target, int size, Usage usage = Usage::Dynamic, int stride = 0);
 
     void setData(std::span<const std::byte> bytes, int offset);
     void setData(const void* ptr, int len, int offset) {
         setData(std::span(static_cast<const std::byte *>(ptr), len), offset);
     }
 
+    // Host-visible buffers are mapped for their whole lifetime, writes through the span land
+    // in the buffer without a flush. Empty for static and CopyDst buffers, which live in
+    // device memory.
+    [[nodiscard]] auto map() const -> std::span<std::byte>;
+    template <typename T>
+    [[nodiscard]] auto map() const -> std::span<T> {
+        const auto bytes = map();
+        return std::span(reinterpret_cast<T*>(bytes.data()), bytes.size() / sizeof(T));
+    }
+
     [[nodiscard]] auto getNativeBufferPtr() const -> void* {
         return impl.get();
     }
     [[nodiscard]] auto getSize() const -> int {
         return size;
     }
+    [[nodiscard]] auto getUsage() const -> Usage {
+        return usage;
+    }
+    [[nodiscard]] auto getStride() const -> int {
+        return stride;
+    }
 
 private:
     struct Dispose {
@@ -36,5 +63,7 @@ private:
 
     int size{};
     Target target{};
+    Usage usage{};
+    int stride{};
     std::unique_ptr<void, Dispose> impl;
 };
\ No newline at end of file
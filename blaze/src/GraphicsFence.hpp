@@ -1,12 +1,11 @@
 #pragma once
 
-#include <memory>
+#include <cstdint>
 
+// A value on the graphics queue's timeline, reached once the submission that returned it has
+// completed.
 struct GraphicsFence {
     friend struct Graphics;
 private:
-    struct Dispose {
-        void operator()(void*);
-    };
-    std::unique_ptr<void, Dispose> impl;
-};
\ No newline at end of file
+    uint64_t value = 0;
+};
@@ -0,0 +1,151 @@
+#include "KTX2.hpp"
+
+#include <bit>
+#include <array>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <VulkanFormatInfo.hpp>
+
+static constexpr auto kIdentifier = std::array<glm::u8, 12>{
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+// dfd, kvd and sgd offsets and lengths, none of which are needed for loading.
+static constexpr size_t kIndexSize = 4 * sizeof(glm::u32) + 2 * sizeof(glm::u64);
+static constexpr size_t kLevelIndexOffset = kIdentifier.size() + sizeof(KTX2Header) + kIndexSize;
+
+template <typename T>
+static auto ReadStruct(ResourceFile& file, size_t offset, T& value) -> bool {
+    return file.read(offset, std::as_writable_bytes(std::span(&value, 1)));
+}
+
+auto KTX2Reader::open(const std::string& filename) -> tl::optional<KTX2Reader> {
+    auto file = Resources::openFile(filename);
+    if (!file) {
+        return tl::nullopt;
+    }
+
+    auto identifier = std::array<glm::u8, 12>{};
+    if (!ReadStruct(*file, 0, identifier) || identifier != kIdentifier) {
+        spdlog::warn("'{}' is not a KTX2 file", filename);
+        return tl::nullopt;
+    }
+
+    auto reader = KTX2Reader{};
+    reader._filename = filename;
+    if (!ReadStruct(*file, kIdentifier.size(), reader._header)) {
+        spdlog::warn("'{}' has a truncated header", filename);
+        return tl::nullopt;
+    }
+
+    const auto& header = reader._header;
+    if (header.vkFormat == VK_FORMAT_UNDEFINED || header.supercompressionScheme != 0) {
+        spdlog::warn("'{}' needs transcoding or decompression, which is not supported", filename);
+        return tl::nullopt;
+    }
+    // Formats missing from the table have a size of 0, a level size could not be checked.
+    const auto format = static_cast<vk::Format>(header.vkFormat);
+    if (GetFormatInfo(format).size == 0) {
+        spdlog::warn("'{}' has an unknown format {}", filename, header.vkFormat);
+        return tl::nullopt;
+    }
+    if (!Texture2D::CanUploadRaw(format)) {
+        spdlog::warn("'{}' is block-compressed, which the device cannot sample", filename);
+        return tl::nullopt;
+    }
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1) {
+        spdlog::warn("'{}' is not a 2D texture", filename);
+        return tl::nullopt;
+    }
+
+    const auto extent = glm::uvec2(header.pixelWidth, header.pixelHeight);
+    if (header.levelCount > static_cast<glm::u32>(std::bit_width(std::max(extent.x, extent.y)))) {
+        spdlog::warn("'{}' has more levels than a full mip chain", filename);
+        return tl::nullopt;
+    }
+
+    reader._levels.resize(std::max(header.levelCount, 1u));
+    if (!file->read(kLevelIndexOffset, std::as_writable_bytes(std::span(reader._levels)))) {
+        spdlog::warn("'{}' has a truncated level index", filename);
+        return tl::nullopt;
+    }
+
+    // Every level is copied to the GPU at its computed size, so the file has to hold exactly that.
+    const auto length = file->length();
+    for (glm::u32 i = 0; i < reader._levels.size(); ++i) {
+        const auto& level = reader._levels[i];
+        if (level.byteLength != GetLevelSize(format, GetMipExtent(extent, i))) {
+            spdlog::warn("'{}' has a level {} of the wrong size", filename, i);
+            return tl::nullopt;
+        }
+        if (level.byteOffset > length || level.byteLength > length - level.byteOffset) {
+            spdlog::warn("'{}' has a level past the end of the file", filename);
+            return tl::nullopt;
+        }
+    }
+
+    reader._file = std::move(*file);
+    return reader;
+}
+
+// The upload is recorded by the time a read fails, so the texture is kept and the level zeroed.
+auto KTX2Reader::createTexture(glm::u32 baseLevel) -> Texture2D {
+    baseLevel = std::min(baseLevel, static_cast<glm::u32>(_levels.size()) - 1);
+    return _createTexture(baseLevel, [&](glm::u32 level, std::span<std::byte> dst) {
+        if (!_file.read(_levels[baseLevel + level].byteOffset, dst)) {
+            spdlog::warn("Failed to read level {} of '{}'", baseLevel + level, _filename);
+            std::memset(dst.data(), 0, dst.size());
+        }
+    });
+}
+
+auto KTX2Reader::readLevels(glm::u32 baseLevel) -> tl::optional<std::vector<std::byte>> {
+    baseLevel = std::min(baseLevel, static_cast<glm::u32>(_levels.size()) - 1);
+
+    auto size = size_t{};
+    for (const auto& level : std::span(_levels).subspan(baseLevel)) {
+        size += level.byteLength;
+    }
+
+    auto bytes = std::vector<std::byte>(size);
+    auto offset = size_t{};
+    for (glm::u32 level = baseLevel; level < _levels.size(); ++level) {
+        if (!_file.read(_levels[level].byteOffset, std::span(bytes).subspan(offset, _levels[level].byteLength))) {
+            spdlog::warn("Failed to read level {} of '{}'", level, _filename);
+            return tl::nullopt;
+        }
+        offset += _levels[level].byteLength;
+    }
+    return bytes;
+}
+
+auto KTX2Reader::createTexture(glm::u32 baseLevel, std::span<const std::byte> levels) const -> Texture2D {
+    baseLevel = std::min(baseLevel, static_cast<glm::u32>(_levels.size()) - 1);
+
+    auto offset = size_t{};
+    return _createTexture(baseLevel, [&](glm::u32, std::span<std::byte> dst) {
+        assert(offset + dst.size() <= levels.size());
+        std::memcpy(dst.data(), levels.data() + offset, dst.size());
+        offset += dst.size();
+    });
+}
+
+auto KTX2Reader::_createTexture(glm::u32 baseLevel, const std::function<void(glm::u32, std::span<std::byte>)>& read) const -> Texture2D {
+    const auto width = std::max(_header.pixelWidth >> baseLevel, 1u);
+    const auto height = std::max(_header.pixelHeight >> baseLevel, 1u);
+    const auto generateMips = _header.levelCount == 0 && Texture2D::CanGenerateMips(getFormat());
+    auto texture = generateMips
+        ? Texture2D(width, height, getFormat(), true)
+        : Texture2D::CreateWithMipCount(width, height, getFormat(), static_cast<glm::u32>(_levels.size()) - baseLevel);
+
+    auto levelSizes = std::vector<vk::DeviceSize>{};
+    levelSizes.reserve(_levels.size() - baseLevel);
+    for (const auto& level : std::span(_levels).subspan(baseLevel)) {
+        levelSizes.emplace_back(level.byteLength);
+    }
+
+    texture.loadRawTextureData(levelSizes, read);
+    return texture;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Texture.hpp"
+#include "Resources.hpp"
+
+#include <string>
+#include <vector>
+#include <tl/optional.hpp>
+
+struct KTX2Header {
+    glm::u32 vkFormat;
+    glm::u32 typeSize;
+    glm::u32 pixelWidth;
+    glm::u32 pixelHeight;
+    glm::u32 pixelDepth;
+    glm::u32 layerCount;
+    glm::u32 faceCount;
+    glm::u32 levelCount;
+    glm::u32 supercompressionScheme;
+};
+
+struct KTX2Level {
+    glm::u64 byteOffset;
+    glm::u64 byteLength;
+    glm::u64 uncompressedByteLength;
+};
+
+// Reads 2D KTX2 textures without supercompression, uncompressed or block-compressed. Opening
+// reads the header and the level index only; the levels are then read from the file straight
+// into staging memory, one read per level.
+struct KTX2Reader {
+    static auto open(const std::string& filename) -> tl::optional<KTX2Reader>;
+
+    // A file without levels below the base gets a generated chain where the format allows it.
+    // A baseLevel above 0 skips the finest levels of a stored chain.
+    auto createTexture(glm::u32 baseLevel = 0) -> Texture2D;
+    // Reads the levels from baseLevel on into memory, one after another, for a texture created
+    // later on. Nothing else may read from the reader meanwhile, other threads included.
+    auto readLevels(glm::u32 baseLevel) -> tl::optional<std::vector<std::byte>>;
+    // Takes what readLevels returned for the same baseLevel.
+    auto createTexture(glm::u32 baseLevel, std::span<const std::byte> levels) const -> Texture2D;
+
+    [[nodiscard]] auto getHeader() const -> const KTX2Header& {
+        return _header;
+    }
+    [[nodiscard]] auto getFormat() const -> vk::Format {
+        return static_cast<vk::Format>(_header.vkFormat);
+    }
+    // Level 0 is the base level.
+    [[nodiscard]] auto getLevels() const -> std::span<const KTX2Level> {
+        return _levels;
+    }
+
+private:
+    auto _createTexture(glm::u32 baseLevel, const std::function<void(glm::u32, std::span<std::byte>)>& read) const -> Texture2D;
+
+    std::string _filename;
+    ResourceFile _file;
+    KTX2Header _header{};
+    std::vector<KTX2Level> _levels;
+};
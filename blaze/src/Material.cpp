@@ -23,6 +23,10 @@ void Material::SetConstantBuffer(uint32_t index, const GraphicsBuffer& buffer) {
     GetGfxDevice().SetConstantBuffer(impl.get(), index, buffer);
 }
 
+void Material::SetPerDrawConstantBuffer(uint32_t index) {
+    GetGfxDevice().SetPerDrawConstantBuffer(impl.get(), index);
+}
+
 void Material::SetTexture(uint32_t index, const Texture2D &texture) {
     GetGfxDevice().SetTexture(impl.get(), index, texture);
 }
@@ -12,6 +12,8 @@ struct Material {
     static auto LoadFromResources(const std::string& filename) -> Material;
 
     void SetConstantBuffer(uint32_t index, const GraphicsBuffer& buffer);
+    // The binding takes its constants from each draw instead of a buffer.
+    void SetPerDrawConstantBuffer(uint32_t index);
     void SetTexture(uint32_t index, const Texture2D& texture);
     auto GetNativeHandlePtr() const -> void* {
         return impl.get();
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+// What the engine allocated memory for. Buffers and textures count their allocation size,
+// pooled vertex and index buffers their range in the shared block and not the block itself.
+enum class MemoryCategory {
+    VertexBuffer,
+    IndexBuffer,
+    ConstantBuffer,
+    TransferBuffer,
+    Texture,
+    DepthStencil
+};
+
+inline constexpr auto kMemoryCategoryNames = std::array{
+    "Vertex buffers",
+    "Index buffers",
+    "Constant buffers",
+    "Transfer buffers",
+    "Textures",
+    "Depth/stencil"
+};
+
+struct MemoryCategoryStatistics {
+    uint32_t count = 0;
+    uint64_t bytes = 0;
+};
+
+struct MemoryHeapStatistics {
+    uint64_t size;
+    bool deviceLocal;
+    // From VK_EXT_memory_budget when the device has it, estimated by VMA otherwise. Usage
+    // includes other processes, the counts below only this one.
+    uint64_t budget;
+    uint64_t usage;
+    uint32_t blockCount;
+    uint32_t allocationCount;
+    uint64_t blockBytes;
+    uint64_t allocationBytes;
+    uint32_t unusedRangeCount;
+    uint64_t largestUnusedRange;
+
+    // 0 while the free space in the heap's blocks is one range, approaching 1 as it splits
+    // into many small ones.
+    [[nodiscard]] auto fragmentation() const -> float {
+        const auto unused = blockBytes - allocationBytes;
+        return unused == 0 ? 0.0f : 1.0f - static_cast<float>(largestUnusedRange) / static_cast<float>(unused);
+    }
+};
+
+struct MemoryStatistics {
+    std::vector<MemoryHeapStatistics> heaps;
+    std::array<MemoryCategoryStatistics, kMemoryCategoryNames.size()> categories;
+};
@@ -10,12 +10,14 @@ struct SubMesh {
 };
 
 struct Mesh {
-    void setVertexBufferParams(int count, size_t elementSize) {
+    // Static buffers suit meshes written once, dynamic ones meshes rewritten every few frames.
+    // A new element size recreates the buffer, draws address pooled ones in elements.
+    void setVertexBufferParams(int count, size_t elementSize, GraphicsBuffer::Usage usage = GraphicsBuffer::Usage::Dynamic) {
         const auto bufferSize = static_cast<int>(count * elementSize);
 
         _vertexCount = count;
-        if (bufferSize > _vertexBuffer.getSize()) {
-            _vertexBuffer = GraphicsBuffer(GraphicsBuffer::Target::Vertex, bufferSize);
+        if (bufferSize > _vertexBuffer.getSize() || usage != _vertexBuffer.getUsage() || static_cast<int>(elementSize) != _vertexBuffer.getStride()) {
+            _vertexBuffer = GraphicsBuffer(GraphicsBuffer::Target::Vertex, bufferSize, usage, static_cast<int>(elementSize));
         }
     }
 
@@ -27,12 +29,12 @@ struct Mesh {
         _vertexBuffer.setData(bytes, len, offset);
     }
 
-    void setIndexBufferParams(int count, size_t elementSize) {
+    void setIndexBufferParams(int count, size_t elementSize, GraphicsBuffer::Usage usage = GraphicsBuffer::Usage::Dynamic) {
         const auto bufferSize = static_cast<int>(count * elementSize);
 
         _indexCount = count;
-        if (bufferSize > _indexBuffer.getSize()) {
-            _indexBuffer = GraphicsBuffer(GraphicsBuffer::Target::Index, bufferSize);
+        if (bufferSize > _indexBuffer.getSize() || usage != _indexBuffer.getUsage() || static_cast<int>(elementSize) != _indexBuffer.getStride()) {
+            _indexBuffer = GraphicsBuffer(GraphicsBuffer::Target::Index, bufferSize, usage, static_cast<int>(elementSize));
         }
     }
     void setIndexBufferData(std::span<const std::byte> bytes, int offset) {
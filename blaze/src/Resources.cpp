@@ -47,6 +47,16 @@ auto Resources::get(const std::string& filename) -> tl::optional<Resource> {
 //#endif
 }
 
+auto Resources::openFile(const std::string& filename) -> tl::optional<ResourceFile> {
+    auto file = ResourceFile{};
+    file.file.reset(PHYSFS_openRead(resolve(filename).c_str()));
+    if (!file.file) {
+        spdlog::warn("Resource '{}' not found", filename);
+        return tl::nullopt;
+    }
+    return file;
+}
+
 auto Resources::open(const std::string &path) -> tl::optional<std::shared_ptr<ResourceStream>> {
     if (auto file = std::make_shared<ResourceStream>(path); *file) {
         return file;
@@ -3,8 +3,11 @@
 #include "Resource.hpp"
 #include "physfs.h"
 
+#include <span>
 #include <array>
+#include <memory>
 #include <string>
+#include <cstddef>
 #include <istream>
 #include <tl/optional.hpp>
 
@@ -62,7 +65,35 @@ private:
     filebuf buf{};
 };
 
+// Random access into a resource without loading it whole, for formats that read parts of a
+// file straight into their destination.
+struct ResourceFile {
+    friend struct Resources;
+
+    [[nodiscard]] auto length() const -> size_t {
+        return static_cast<size_t>(PHYSFS_fileLength(file.get()));
+    }
+
+    // Fills all of bytes from offset, returns false on a short read.
+    auto read(size_t offset, std::span<std::byte> bytes) -> bool {
+        if (PHYSFS_seek(file.get(), offset) == 0) {
+            return false;
+        }
+        const auto len = PHYSFS_readBytes(file.get(), bytes.data(), bytes.size());
+        return len == static_cast<PHYSFS_sint64>(bytes.size());
+    }
+
+private:
+    struct Close {
+        void operator()(PHYSFS_File* file) {
+            PHYSFS_close(file);
+        }
+    };
+    std::unique_ptr<PHYSFS_File, Close> file;
+};
+
 struct Resources {
     static auto get(const std::string& filename) -> tl::optional<Resource>;
     static auto open(const std::string& path) -> tl::optional<std::shared_ptr<ResourceStream>>;
+    static auto openFile(const std::string& filename) -> tl::optional<ResourceFile>;
 };
\ No newline at end of file
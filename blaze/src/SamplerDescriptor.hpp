@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+enum class FilterMode {
+    Point,
+    Bilinear,
+    Trilinear
+};
+
+enum class TextureWrapMode {
+    Repeat,
+    Clamp,
+    Mirror
+};
+
+// Sampler state of a texture. Textures with equal descriptors share one device sampler.
+struct SamplerDescriptor {
+    FilterMode filterMode = FilterMode::Point;
+    TextureWrapMode wrapMode = TextureWrapMode::Repeat;
+    // Anisotropic filtering is off at 0 and 1 and clamped to the device limit above that.
+    glm::u32 anisoLevel = 1;
+    glm::f32 mipMapBias = 0.0f;
+
+    auto operator==(const SamplerDescriptor&) const -> bool = default;
+};
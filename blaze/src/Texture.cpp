@@ -5,303 +5,20 @@
 #include "Blaze.hpp"
 #include "GraphicsFence.hpp"
 
-#include <map>
+#include <bit>
+#include <vector>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <tl/optional.hpp>
 #include <VulkanTexture.hpp>
 #include <VulkanGfxDevice.hpp>
+#include <VulkanStagingRing.hpp>
+#include <VulkanFormatInfo.hpp>
 #include <VulkanGraphicsBuffer.hpp>
 
 extern auto GetGfxDevice() -> VulkanGfxDevice&;
 
-struct VULKAN_FORMAT_INFO {
-    int size;
-    int channels;
-//    VkFormatCompatibilityClass format_class;
-};
-
-const auto vk_format_table = std::map<vk::Format, VULKAN_FORMAT_INFO>{
-//    { vk::Format::eUndefined,                                { 0, 0 } },
-//    { vk::Format::eR4G4UnormPack8,                           { 0, 0 } },
-//    { vk::Format::eR4G4B4A4UnormPack16,                      { 0, 0 } },
-//    { vk::Format::eB4G4R4A4UnormPack16,                      { 0, 0 } },
-//    { vk::Format::eR5G6B5UnormPack16,                        { 0, 0 } },
-//    { vk::Format::eB5G6R5UnormPack16,                        { 0, 0 } },
-//    { vk::Format::eR5G5B5A1UnormPack16,                      { 0, 0 } },
-//    { vk::Format::eB5G5R5A1UnormPack16,                      { 0, 0 } },
-//    { vk::Format::eA1R5G5B5UnormPack16,                      { 0, 0 } },
-//    { vk::Format::eR8Unorm,                                  { 0, 0 } },
-//    { vk::Format::eR8Snorm,                                  { 0, 0 } },
-//    { vk::Format::eR8Uscaled,                                { 0, 0 } },
-//    { vk::Format::eR8Sscaled,                                { 0, 0 } },
-//    { vk::Format::eR8Uint,                                   { 0, 0 } },
-//    { vk::Format::eR8Sint,                                   { 0, 0 } },
-//    { vk::Format::eR8Srgb,                                   { 0, 0 } },
-//    { vk::Format::eR8G8Unorm,                                { 0, 0 } },
-//    { vk::Format::eR8G8Snorm,                                { 0, 0 } },
-//    { vk::Format::eR8G8Uscaled,                              { 0, 0 } },
-//    { vk::Format::eR8G8Sscaled,                              { 0, 0 } },
-//    { vk::Format::eR8G8Uint,                                 { 0, 0 } },
-//    { vk::Format::eR8G8Sint,                                 { 0, 0 } },
-//    { vk::Format::eR8G8Srgb,                                 { 0, 0 } },
-//    { vk::Format::eR8G8B8Unorm,                              { 0, 0 } },
-//    { vk::Format::eR8G8B8Snorm,                              { 0, 0 } },
-//    { vk::Format::eR8G8B8Uscaled,                            { 0, 0 } },
-//    { vk::Format::eR8G8B8Sscaled,                            { 0, 0 } },
-//    { vk::Format::eR8G8B8Uint,                               { 0, 0 } },
-//    { vk::Format::eR8G8B8Sint,                               { 0, 0 } },
-//    { vk::Format::eR8G8B8Srgb,                               { 0, 0 } },
-//    { vk::Format::eB8G8R8Unorm,                              { 0, 0 } },
-//    { vk::Format::eB8G8R8Snorm,                              { 0, 0 } },
-//    { vk::Format::eB8G8R8Uscaled,                            { 0, 0 } },
-//    { vk::Format::eB8G8R8Sscaled,                            { 0, 0 } },
-//    { vk::Format::eB8G8R8Uint,                               { 0, 0 } },
-//    { vk::Format::eB8G8R8Sint,                               { 0, 0 } },
-//    { vk::Format::eB8G8R8Srgb,                               { 0, 0 } },
-    { vk::Format::eR8G8B8A8Unorm,                            { 0, 4 } },
-    { vk::Format::eR8G8B8A8Snorm,                            { 0, 4 } },
-    { vk::Format::eR8G8B8A8Uscaled,                          { 0, 4 } },
-    { vk::Format::eR8G8B8A8Sscaled,                          { 0, 4 } },
-    { vk::Format::eR8G8B8A8Uint,                             { 0, 4 } },
-    { vk::Format::eR8G8B8A8Sint,                             { 0, 4 } },
-    { vk::Format::eR8G8B8A8Srgb,                             { 0, 4 } },
-//    { vk::Format::eB8G8R8A8Unorm,                            { 0, 0 } },
-//    { vk::Format::eB8G8R8A8Snorm,                            { 0, 0 } },
-//    { vk::Format::eB8G8R8A8Uscaled,                          { 0, 0 } },
-//    { vk::Format::eB8G8R8A8Sscaled,                          { 0, 0 } },
-//    { vk::Format::eB8G8R8A8Uint,                             { 0, 0 } },
-//    { vk::Format::eB8G8R8A8Sint,                             { 0, 0 } },
-//    { vk::Format::eB8G8R8A8Srgb,                             { 0, 0 } },
-//    { vk::Format::eA8B8G8R8UnormPack32,                      { 0, 0 } },
-//    { vk::Format::eA8B8G8R8SnormPack32,                      { 0, 0 } },
-//    { vk::Format::eA8B8G8R8UscaledPack32,                    { 0, 0 } },
-//    { vk::Format::eA8B8G8R8SscaledPack32,                    { 0, 0 } },
-//    { vk::Format::eA8B8G8R8UintPack32,                       { 0, 0 } },
-//    { vk::Format::eA8B8G8R8SintPack32,                       { 0, 0 } },
-//    { vk::Format::eA8B8G8R8SrgbPack32,                       { 0, 0 } },
-//    { vk::Format::eA2R10G10B10UnormPack32,                   { 0, 0 } },
-//    { vk::Format::eA2R10G10B10SnormPack32,                   { 0, 0 } },
-//    { vk::Format::eA2R10G10B10UscaledPack32,                 { 0, 0 } },
-//    { vk::Format::eA2R10G10B10SscaledPack32,                 { 0, 0 } },
-//    { vk::Format::eA2R10G10B10UintPack32,                    { 0, 0 } },
-//    { vk::Format::eA2R10G10B10SintPack32,                    { 0, 0 } },
-//    { vk::Format::eA2B10G10R10UnormPack32,                   { 0, 0 } },
-//    { vk::Format::eA2B10G10R10SnormPack32,                   { 0, 0 } },
-//    { vk::Format::eA2B10G10R10UscaledPack32,                 { 0, 0 } },
-//    { vk::Format::eA2B10G10R10SscaledPack32,                 { 0, 0 } },
-//    { vk::Format::eA2B10G10R10UintPack32,                    { 0, 0 } },
-//    { vk::Format::eA2B10G10R10SintPack32,                    { 0, 0 } },
-//    { vk::Format::eR16Unorm,                                 { 0, 0 } },
-//    { vk::Format::eR16Snorm,                                 { 0, 0 } },
-//    { vk::Format::eR16Uscaled,                               { 0, 0 } },
-//    { vk::Format::eR16Sscaled,                               { 0, 0 } },
-//    { vk::Format::eR16Uint,                                  { 0, 0 } },
-//    { vk::Format::eR16Sint,                                  { 0, 0 } },
-//    { vk::Format::eR16Sfloat,                                { 0, 0 } },
-//    { vk::Format::eR16G16Unorm,                              { 0, 0 } },
-//    { vk::Format::eR16G16Snorm,                              { 0, 0 } },
-//    { vk::Format::eR16G16Uscaled,                            { 0, 0 } },
-//    { vk::Format::eR16G16Sscaled,                            { 0, 0 } },
-//    { vk::Format::eR16G16Uint,                               { 0, 0 } },
-//    { vk::Format::eR16G16Sint,                               { 0, 0 } },
-//    { vk::Format::eR16G16Sfloat,                             { 0, 0 } },
-//    { vk::Format::eR16G16B16Unorm,                           { 0, 0 } },
-//    { vk::Format::eR16G16B16Snorm,                           { 0, 0 } },
-//    { vk::Format::eR16G16B16Uscaled,                         { 0, 0 } },
-//    { vk::Format::eR16G16B16Sscaled,                         { 0, 0 } },
-//    { vk::Format::eR16G16B16Uint,                            { 0, 0 } },
-//    { vk::Format::eR16G16B16Sint,                            { 0, 0 } },
-//    { vk::Format::eR16G16B16Sfloat,                          { 0, 0 } },
-//    { vk::Format::eR16G16B16A16Unorm,                        { 0, 0 } },
-//    { vk::Format::eR16G16B16A16Snorm,                        { 0, 0 } },
-//    { vk::Format::eR16G16B16A16Uscaled,                      { 0, 0 } },
-//    { vk::Format::eR16G16B16A16Sscaled,                      { 0, 0 } },
-//    { vk::Format::eR16G16B16A16Uint,                         { 0, 0 } },
-//    { vk::Format::eR16G16B16A16Sint,                         { 0, 0 } },
-//    { vk::Format::eR16G16B16A16Sfloat,                       { 0, 0 } },
-//    { vk::Format::eR32Uint,                                  { 0, 0 } },
-//    { vk::Format::eR32Sint,                                  { 0, 0 } },
-//    { vk::Format::eR32Sfloat,                                { 0, 0 } },
-//    { vk::Format::eR32G32Uint,                               { 0, 0 } },
-//    { vk::Format::eR32G32Sint,                               { 0, 0 } },
-//    { vk::Format::eR32G32Sfloat,                             { 0, 0 } },
-//    { vk::Format::eR32G32B32Uint,                            { 0, 0 } },
-//    { vk::Format::eR32G32B32Sint,                            { 0, 0 } },
-//    { vk::Format::eR32G32B32Sfloat,                          { 0, 0 } },
-//    { vk::Format::eR32G32B32A32Uint,                         { 0, 0 } },
-//    { vk::Format::eR32G32B32A32Sint,                         { 0, 0 } },
-//    { vk::Format::eR32G32B32A32Sfloat,                       { 0, 0 } },
-//    { vk::Format::eR64Uint,                                  { 0, 0 } },
-//    { vk::Format::eR64Sint,                                  { 0, 0 } },
-//    { vk::Format::eR64Sfloat,                                { 0, 0 } },
-//    { vk::Format::eR64G64Uint,                               { 0, 0 } },
-//    { vk::Format::eR64G64Sint,                               { 0, 0 } },
-//    { vk::Format::eR64G64Sfloat,                             { 0, 0 } },
-//    { vk::Format::eR64G64B64Uint,                            { 0, 0 } },
-//    { vk::Format::eR64G64B64Sint,                            { 0, 0 } },
-//    { vk::Format::eR64G64B64Sfloat,                          { 0, 0 } },
-//    { vk::Format::eR64G64B64A64Uint,                         { 0, 0 } },
-//    { vk::Format::eR64G64B64A64Sint,                         { 0, 0 } },
-//    { vk::Format::eR64G64B64A64Sfloat,                       { 0, 0 } },
-//    { vk::Format::eB10G11R11UfloatPack32,                    { 0, 0 } },
-//    { vk::Format::eE5B9G9R9UfloatPack32,                     { 0, 0 } },
-//    { vk::Format::eD16Unorm,                                 { 0, 0 } },
-//    { vk::Format::eX8D24UnormPack32,                         { 0, 0 } },
-//    { vk::Format::eD32Sfloat,                                { 0, 0 } },
-//    { vk::Format::eS8Uint,                                   { 0, 0 } },
-//    { vk::Format::eD16UnormS8Uint,                           { 0, 0 } },
-//    { vk::Format::eD24UnormS8Uint,                           { 0, 0 } },
-//    { vk::Format::eD32SfloatS8Uint,                          { 0, 0 } },
-//    { vk::Format::eBc1RgbUnormBlock,                         { 0, 0 } },
-//    { vk::Format::eBc1RgbSrgbBlock,                          { 0, 0 } },
-//    { vk::Format::eBc1RgbaUnormBlock,                        { 0, 0 } },
-//    { vk::Format::eBc1RgbaSrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eBc2UnormBlock,                            { 0, 0 } },
-//    { vk::Format::eBc2SrgbBlock,                             { 0, 0 } },
-//    { vk::Format::eBc3UnormBlock,                            { 0, 0 } },
-//    { vk::Format::eBc3SrgbBlock,                             { 0, 0 } },
-//    { vk::Format::eBc4UnormBlock,                            { 0, 0 } },
-//    { vk::Format::eBc4SnormBlock,                            { 0, 0 } },
-//    { vk::Format::eBc5UnormBlock,                            { 0, 0 } },
-//    { vk::Format::eBc5SnormBlock,                            { 0, 0 } },
-//    { vk::Format::eBc6HUfloatBlock,                          { 0, 0 } },
-//    { vk::Format::eBc6HSfloatBlock,                          { 0, 0 } },
-//    { vk::Format::eBc7UnormBlock,                            { 0, 0 } },
-//    { vk::Format::eBc7SrgbBlock,                             { 0, 0 } },
-//    { vk::Format::eEtc2R8G8B8UnormBlock,                     { 0, 0 } },
-//    { vk::Format::eEtc2R8G8B8SrgbBlock,                      { 0, 0 } },
-//    { vk::Format::eEtc2R8G8B8A1UnormBlock,                   { 0, 0 } },
-//    { vk::Format::eEtc2R8G8B8A1SrgbBlock,                    { 0, 0 } },
-//    { vk::Format::eEtc2R8G8B8A8UnormBlock,                   { 0, 0 } },
-//    { vk::Format::eEtc2R8G8B8A8SrgbBlock,                    { 0, 0 } },
-//    { vk::Format::eEacR11UnormBlock,                         { 0, 0 } },
-//    { vk::Format::eEacR11SnormBlock,                         { 0, 0 } },
-//    { vk::Format::eEacR11G11UnormBlock,                      { 0, 0 } },
-//    { vk::Format::eEacR11G11SnormBlock,                      { 0, 0 } },
-//    { vk::Format::eAstc4x4UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc4x4SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc5x4UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc5x4SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc5x5UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc5x5SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc6x5UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc6x5SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc6x6UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc6x6SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc8x5UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc8x5SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc8x6UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc8x6SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc8x8UnormBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc8x8SrgbBlock,                         { 0, 0 } },
-//    { vk::Format::eAstc10x5UnormBlock,                       { 0, 0 } },
-//    { vk::Format::eAstc10x5SrgbBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc10x6UnormBlock,                       { 0, 0 } },
-//    { vk::Format::eAstc10x6SrgbBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc10x8UnormBlock,                       { 0, 0 } },
-//    { vk::Format::eAstc10x8SrgbBlock,                        { 0, 0 } },
-//    { vk::Format::eAstc10x10UnormBlock,                      { 0, 0 } },
-//    { vk::Format::eAstc10x10SrgbBlock,                       { 0, 0 } },
-//    { vk::Format::eAstc12x10UnormBlock,                      { 0, 0 } },
-//    { vk::Format::eAstc12x10SrgbBlock,                       { 0, 0 } },
-//    { vk::Format::eAstc12x12UnormBlock,                      { 0, 0 } },
-//    { vk::Format::eAstc12x12SrgbBlock,                       { 0, 0 } },
-//    { vk::Format::eG8B8G8R8422Unorm,                         { 0, 0 } },
-//    { vk::Format::eB8G8R8G8422Unorm,                         { 0, 0 } },
-//    { vk::Format::eG8B8R83Plane420Unorm,                     { 0, 0 } },
-//    { vk::Format::eG8B8R82Plane420Unorm,                     { 0, 0 } },
-//    { vk::Format::eG8B8R83Plane422Unorm,                     { 0, 0 } },
-//    { vk::Format::eG8B8R82Plane422Unorm,                     { 0, 0 } },
-//    { vk::Format::eG8B8R83Plane444Unorm,                     { 0, 0 } },
-//    { vk::Format::eR10X6UnormPack16,                         { 0, 0 } },
-//    { vk::Format::eR10X6G10X6Unorm2Pack16,                   { 0, 0 } },
-//    { vk::Format::eR10X6G10X6B10X6A10X6Unorm4Pack16,         { 0, 0 } },
-//    { vk::Format::eG10X6B10X6G10X6R10X6422Unorm4Pack16,      { 0, 0 } },
-//    { vk::Format::eB10X6G10X6R10X6G10X6422Unorm4Pack16,      { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X63Plane420Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X62Plane420Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X63Plane422Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X62Plane422Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X63Plane444Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eR12X4UnormPack16,                         { 0, 0 } },
-//    { vk::Format::eR12X4G12X4Unorm2Pack16,                   { 0, 0 } },
-//    { vk::Format::eR12X4G12X4B12X4A12X4Unorm4Pack16,         { 0, 0 } },
-//    { vk::Format::eG12X4B12X4G12X4R12X4422Unorm4Pack16,      { 0, 0 } },
-//    { vk::Format::eB12X4G12X4R12X4G12X4422Unorm4Pack16,      { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X43Plane420Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X42Plane420Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X43Plane422Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X42Plane422Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X43Plane444Unorm3Pack16,     { 0, 0 } },
-//    { vk::Format::eG16B16G16R16422Unorm,                     { 0, 0 } },
-//    { vk::Format::eB16G16R16G16422Unorm,                     { 0, 0 } },
-//    { vk::Format::eG16B16R163Plane420Unorm,                  { 0, 0 } },
-//    { vk::Format::eG16B16R162Plane420Unorm,                  { 0, 0 } },
-//    { vk::Format::eG16B16R163Plane422Unorm,                  { 0, 0 } },
-//    { vk::Format::eG16B16R162Plane422Unorm,                  { 0, 0 } },
-//    { vk::Format::eG16B16R163Plane444Unorm,                  { 0, 0 } },
-//    { vk::Format::ePvrtc12BppUnormBlockIMG,                  { 0, 0 } },
-//    { vk::Format::ePvrtc14BppUnormBlockIMG,                  { 0, 0 } },
-//    { vk::Format::ePvrtc22BppUnormBlockIMG,                  { 0, 0 } },
-//    { vk::Format::ePvrtc24BppUnormBlockIMG,                  { 0, 0 } },
-//    { vk::Format::ePvrtc12BppSrgbBlockIMG,                   { 0, 0 } },
-//    { vk::Format::ePvrtc14BppSrgbBlockIMG,                   { 0, 0 } },
-//    { vk::Format::ePvrtc22BppSrgbBlockIMG,                   { 0, 0 } },
-//    { vk::Format::ePvrtc24BppSrgbBlockIMG,                   { 0, 0 } },
-//    { vk::Format::eAstc4x4SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc5x4SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc5x5SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc6x5SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc6x6SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc8x5SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc8x6SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc8x8SfloatBlockEXT,                    { 0, 0 } },
-//    { vk::Format::eAstc10x5SfloatBlockEXT,                   { 0, 0 } },
-//    { vk::Format::eAstc10x6SfloatBlockEXT,                   { 0, 0 } },
-//    { vk::Format::eAstc10x8SfloatBlockEXT,                   { 0, 0 } },
-//    { vk::Format::eAstc10x10SfloatBlockEXT,                  { 0, 0 } },
-//    { vk::Format::eAstc12x10SfloatBlockEXT,                  { 0, 0 } },
-//    { vk::Format::eAstc12x12SfloatBlockEXT,                  { 0, 0 } },
-//    { vk::Format::eG8B8R82Plane444UnormEXT,                  { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X62Plane444Unorm3Pack16EXT,  { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X42Plane444Unorm3Pack16EXT,  { 0, 0 } },
-//    { vk::Format::eG16B16R162Plane444UnormEXT,               { 0, 0 } },
-//    { vk::Format::eA4R4G4B4UnormPack16EXT,                   { 0, 0 } },
-//    { vk::Format::eA4B4G4R4UnormPack16EXT,                   { 0, 0 } },
-//    { vk::Format::eB10X6G10X6R10X6G10X6422Unorm4Pack16KHR,   { 0, 0 } },
-//    { vk::Format::eB12X4G12X4R12X4G12X4422Unorm4Pack16KHR,   { 0, 0 } },
-//    { vk::Format::eB16G16R16G16422UnormKHR,                  { 0, 0 } },
-//    { vk::Format::eB8G8R8G8422UnormKHR,                      { 0, 0 } },
-//    { vk::Format::eG10X6B10X6G10X6R10X6422Unorm4Pack16KHR,   { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X62Plane420Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X62Plane422Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X63Plane420Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X63Plane422Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG10X6B10X6R10X63Plane444Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG12X4B12X4G12X4R12X4422Unorm4Pack16KHR,   { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X42Plane420Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X42Plane422Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X43Plane420Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X43Plane422Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG12X4B12X4R12X43Plane444Unorm3Pack16KHR,  { 0, 0 } },
-//    { vk::Format::eG16B16G16R16422UnormKHR,                  { 0, 0 } },
-//    { vk::Format::eG16B16R162Plane420UnormKHR,               { 0, 0 } },
-//    { vk::Format::eG16B16R162Plane422UnormKHR,               { 0, 0 } },
-//    { vk::Format::eG16B16R163Plane420UnormKHR,               { 0, 0 } },
-//    { vk::Format::eG16B16R163Plane422UnormKHR,               { 0, 0 } },
-//    { vk::Format::eG16B16R163Plane444UnormKHR,               { 0, 0 } },
-//    { vk::Format::eG8B8G8R8422UnormKHR,                      { 0, 0 } },
-//    { vk::Format::eG8B8R82Plane420UnormKHR,                  { 0, 0 } },
-//    { vk::Format::eG8B8R82Plane422UnormKHR,                  { 0, 0 } },
-//    { vk::Format::eG8B8R83Plane420UnormKHR,                  { 0, 0 } },
-//    { vk::Format::eG8B8R83Plane422UnormKHR,                  { 0, 0 } },
-//    { vk::Format::eG8B8R83Plane444UnormKHR,                  { 0, 0 } },
-//    { vk::Format::eR10X6G10X6B10X6A10X6Unorm4Pack16KHR,      { 0, 0 } },
-//    { vk::Format::eR10X6G10X6Unorm2Pack16KHR,                { 0, 0 } },
-//    { vk::Format::eR10X6UnormPack16KHR,                      { 0, 0 } },
-//    { vk::Format::eR12X4G12X4B12X4A12X4Unorm4Pack16KHR,      { 0, 0 } },
-//    { vk::Format::eR12X4G12X4Unorm2Pack16KHR,                { 0, 0 } },
-//    { vk::Format::eR12X4UnormPack16KHR,                      { 0, 0 } },
-};
-
 void Texture::Dispose::operator()(void* texture) {
     GetGfxDevice().DestroyTexture(texture);
 }
@@ -322,40 +39,453 @@ auto Texture::getImageView() const -> vk::ImageView {
     return static_cast<VulkanTexture*>(impl.get())->imageView;
 }
 
-Texture2D::Texture2D(glm::u32 width, glm::u32 height, vk::Format format) : _width(width), _height(height) {
-    impl.reset(GetGfxDevice().CreateTexture(width, height, format));
+static auto GetMipCount(glm::u32 width, glm::u32 height) -> glm::u32 {
+    return static_cast<glm::u32>(std::bit_width(std::max(width, height)));
+}
+
+static auto GetBlockFormat(vk::Format format) -> tl::optional<BlockFormat> {
+    switch (format) {
+        case vk::Format::eBc1RgbUnormBlock:
+        case vk::Format::eBc1RgbSrgbBlock:
+            return BlockFormat::BC1;
+        case vk::Format::eBc1RgbaUnormBlock:
+        case vk::Format::eBc1RgbaSrgbBlock:
+            return BlockFormat::BC1A;
+        case vk::Format::eBc3UnormBlock:
+        case vk::Format::eBc3SrgbBlock:
+            return BlockFormat::BC3;
+        case vk::Format::eBc4UnormBlock:
+            return BlockFormat::BC4;
+        case vk::Format::eBc5UnormBlock:
+            return BlockFormat::BC5;
+        case vk::Format::eBc7UnormBlock:
+        case vk::Format::eBc7SrgbBlock:
+            return BlockFormat::BC7;
+        default:
+            return tl::nullopt;
+    }
+}
+
+// What a block-compressed texture is created as on devices without BC sampling, setPixels
+// then uploads the pixels as they are.
+static auto GetUncompressedFormat(vk::Format format) -> vk::Format {
+    switch (format) {
+        case vk::Format::eBc1RgbSrgbBlock:
+        case vk::Format::eBc1RgbaSrgbBlock:
+        case vk::Format::eBc3SrgbBlock:
+        case vk::Format::eBc7SrgbBlock:
+            return vk::Format::eR8G8B8A8Srgb;
+        default:
+            return vk::Format::eR8G8B8A8Unorm;
+    }
+}
+
+Texture2D::Texture2D(glm::u32 width, glm::u32 height, vk::Format format, bool mipChain) {
+    _create(width, height, format, mipChain ? GetMipCount(width, height) : 1);
+}
+
+auto Texture2D::CreateWithMipCount(glm::u32 width, glm::u32 height, vk::Format format, glm::u32 mipCount) -> Texture2D {
+    auto texture = Texture2D{};
+    texture._create(width, height, format, std::clamp(mipCount, 1u, GetMipCount(width, height)));
+    return texture;
+}
+
+auto Texture2D::CanGenerateMips(vk::Format format) -> bool {
+    return GetGfxDevice().SupportsLinearBlit(format);
+}
+
+auto Texture2D::CanUploadRaw(vk::Format format) -> bool {
+    return !GetBlockFormat(format) || GetGfxDevice().SupportsTextureCompressionBC();
+}
+
+void Texture2D::_create(glm::u32 width, glm::u32 height, vk::Format format, glm::u32 mipCount) {
+    if (!CanUploadRaw(format)) {
+        format = GetUncompressedFormat(format);
+    }
+    _width = width;
+    _height = height;
+    _format = format;
+    _mipCount = mipCount;
+    _blitMips = _mipCount > 1 && CanGenerateMips(format);
+    _sampler.filterMode = _mipCount > 1 ? FilterMode::Trilinear : FilterMode::Point;
+    impl.reset(GetGfxDevice().CreateTexture(width, height, format, _mipCount, _sampler));
+}
+
+void Texture2D::setFilterMode(FilterMode filterMode) {
+    setSamplerDescriptor({filterMode, _sampler.wrapMode, _sampler.anisoLevel, _sampler.mipMapBias});
+}
+
+void Texture2D::setWrapMode(TextureWrapMode wrapMode) {
+    setSamplerDescriptor({_sampler.filterMode, wrapMode, _sampler.anisoLevel, _sampler.mipMapBias});
+}
+
+void Texture2D::setAnisoLevel(glm::u32 anisoLevel) {
+    setSamplerDescriptor({_sampler.filterMode, _sampler.wrapMode, anisoLevel, _sampler.mipMapBias});
+}
+
+void Texture2D::setMipMapBias(glm::f32 mipMapBias) {
+    setSamplerDescriptor({_sampler.filterMode, _sampler.wrapMode, _sampler.anisoLevel, mipMapBias});
+}
+
+void Texture2D::setSamplerDescriptor(const SamplerDescriptor& descriptor) {
+    if (descriptor == _sampler) {
+        return;
+    }
+    _sampler = descriptor;
+    GetGfxDevice().SetSampler(impl.get(), _sampler);
+}
+
+// Copies are placed at a multiple of 16 bytes in the staging memory, which buffer offsets
+// must also keep a multiple of the texel or block size.
+static constexpr vk::DeviceSize kStagingAlignment = 16;
+
+static constexpr auto GetStagingAlignment(vk::Format format) -> vk::DeviceSize {
+    return std::lcm(kStagingAlignment, std::max<vk::DeviceSize>(GetFormatInfo(format).size, 1));
+}
+
+static auto GetCopyRegion(vk::Format format, const TextureRegion& region, vk::DeviceSize bufferOffset, glm::u32 mipLevel = 0) -> vk::BufferImageCopy {
+    return vk::BufferImageCopy{
+        .bufferOffset = bufferOffset,
+        .imageSubresource = {
+            .aspectMask = GetFormatInfo(format).aspect,
+            .mipLevel = mipLevel,
+            .layerCount = 1
+        },
+        .imageOffset = {
+            .x = static_cast<int32_t>(region.offset.x),
+            .y = static_cast<int32_t>(region.offset.y)
+        },
+        .imageExtent = {
+            .width = region.extent.x,
+            .height = region.extent.y,
+            .depth = 1
+        }
+    };
+}
+
+// Tiled sources are converted in storage order first, so the conversion always runs over
+// contiguous memory, and then de-tiled.
+template <typename Pixel, typename Fn>
+static void ConvertToStaging(const HDRTextureData& data, std::span<Pixel> dst, Fn&& convert) {
+    if (data.getLayout() == TextureLayout::Linear) {
+        convert(data.getPixels(), dst);
+        return;
+    }
+    const auto extent = glm::uvec2(data.getDimension());
+    auto tiled = BasicTextureData<Pixel>::Create(extent.x, extent.y, data.getLayout());
+    convert(data.getPixels(), tiled.getPixels());
+    tiled.copyPixels(dst);
+}
+
+// Builds the chain in place, every level is stored right behind the one it is filtered from.
+template <typename Pixel>
+static void GenerateMips(std::byte* chain, glm::uvec2 extent, glm::u32 mipCount) {
+    auto src = reinterpret_cast<Pixel*>(chain);
+    for (glm::u32 level = 1; level < mipCount; ++level) {
+        const auto srcExtent = GetMipExtent(extent, level - 1);
+        const auto dstExtent = GetMipExtent(extent, level);
+        const auto dst = src + static_cast<size_t>(srcExtent.x) * srcExtent.y;
+        DownsamplePixels(
+            std::span<const Pixel>(src, static_cast<size_t>(srcExtent.x) * srcExtent.y),
+            srcExtent,
+            std::span<Pixel>(dst, static_cast<size_t>(dstExtent.x) * dstExtent.y)
+        );
+        src = dst;
+    }
 }
 
 void Texture2D::setPixels(std::span<const glm::u8vec4> pixels) {
-    auto stagingBuffer = GraphicsBuffer(GraphicsBuffer::Target::CopySrc, static_cast<int>(pixels.size_bytes()));
-    stagingBuffer.setData(std::as_bytes(pixels), 0);
+    if (GetBlockFormat(_format)) {
+        _uploadCompressed(pixels);
+        return;
+    }
+    auto region = GetCopyRegion(_format, {.extent = {_width, _height}}, 0);
+    _upload(pixels.size_bytes(), std::span(&region, 1), [&](std::byte* data) {
+        std::memcpy(data, pixels.data(), pixels.size_bytes());
+    });
+}
+
+// De-tiles straight into the staging memory instead of going through a linear copy.
+void Texture2D::setPixels(const TextureData& data) {
+    assert(glm::uvec2(data.getDimension()) == glm::uvec2(_width, _height));
+
+    const auto count = static_cast<size_t>(_width) * _height;
+    if (GetBlockFormat(_format)) {
+        auto pixels = std::vector<glm::u8vec4>(count);
+        data.copyPixels(pixels);
+        _uploadCompressed(pixels);
+        return;
+    }
+
+    auto region = GetCopyRegion(_format, {.extent = {_width, _height}}, 0);
+    _upload(count * sizeof(glm::u8vec4), std::span(&region, 1), [&](std::byte* ptr) {
+        data.copyPixels(std::span(reinterpret_cast<glm::u8vec4*>(ptr), count));
+    });
+}
+
+// Packs the regions one after another into the staging memory, one copy per region.
+void Texture2D::setPixels(const TextureData& data, std::span<const TextureRegion> regions) {
+    assert(glm::uvec2(data.getDimension()) == glm::uvec2(_width, _height));
+    if (regions.empty()) {
+        return;
+    }
+    // A chain built on the CPU and the block encoder both need the whole of level 0.
+    if ((_mipCount > 1 && !_blitMips) || GetBlockFormat(_format)) {
+        setPixels(data);
+        return;
+    }
+
+    auto count = size_t{};
+    auto copies = std::vector<vk::BufferImageCopy>{};
+    copies.reserve(regions.size());
+    for (const auto& region : regions) {
+        copies.emplace_back(GetCopyRegion(_format, region, count * sizeof(glm::u8vec4)));
+        count += region.getArea();
+    }
+
+    _upload(count * sizeof(glm::u8vec4), copies, [&](std::byte* ptr) {
+        auto pixels = reinterpret_cast<glm::u8vec4*>(ptr);
+        for (const auto& region : regions) {
+            data.copyPixels(std::span(pixels, region.getArea()), region);
+            pixels += region.getArea();
+        }
+    });
+}
+
+void Texture2D::setDirtyPixels(TextureData& data) {
+    setPixels(data, data.getDirtyRegions());
+    data.clearDirtyRegions();
+}
+
+// Float formats are uploaded as is or packed to half, 8-bit formats go through the conversion.
+void Texture2D::setPixels(const HDRTextureData& data, const TextureConversion& conversion) {
+    assert(glm::uvec2(data.getDimension()) == glm::uvec2(_width, _height));
+
+    const auto count = static_cast<size_t>(_width) * _height;
+    auto region = GetCopyRegion(_format, {.extent = {_width, _height}}, 0);
+    switch (_format) {
+        case vk::Format::eR32G32B32A32Sfloat: {
+            _upload(count * sizeof(glm::vec4), std::span(&region, 1), [&](std::byte* ptr) {
+                data.copyPixels(std::span(reinterpret_cast<glm::vec4*>(ptr), count));
+            });
+            break;
+        }
+        case vk::Format::eR16G16B16A16Sfloat: {
+            _upload(count * sizeof(glm::u16vec4), std::span(&region, 1), [&](std::byte* ptr) {
+                ConvertToStaging(data, std::span(reinterpret_cast<glm::u16vec4*>(ptr), count), [](std::span<const glm::vec4> src, std::span<glm::u16vec4> dst) {
+                    ConvertPixels(src, dst);
+                });
+            });
+            break;
+        }
+        default: {
+            if (GetBlockFormat(_format)) {
+                auto pixels = std::vector<glm::u8vec4>(count);
+                ConvertToStaging(data, std::span(pixels), [&](std::span<const glm::vec4> src, std::span<glm::u8vec4> dst) {
+                    ConvertPixels(src, dst, conversion);
+                });
+                _uploadCompressed(pixels);
+                break;
+            }
+            _upload(count * sizeof(glm::u8vec4), std::span(&region, 1), [&](std::byte* ptr) {
+                ConvertToStaging(data, std::span(reinterpret_cast<glm::u8vec4*>(ptr), count), [&](std::span<const glm::vec4> src, std::span<glm::u8vec4> dst) {
+                    ConvertPixels(src, dst, conversion);
+                });
+            });
+            break;
+        }
+    }
+}
+
+// Blocks are laid out level after level, each level in row-major block order.
+void Texture2D::setCompressedPixels(std::span<const std::byte> blocks) {
+    assert(GetFormatInfo(_format).isCompressed() && "BC textures fall back to RGBA8 without device support");
+
+    auto levelSizes = std::vector<vk::DeviceSize>{};
+    for (glm::u32 level = 0; level < _mipCount; ++level) {
+        levelSizes.emplace_back(GetLevelSize(_format, GetMipExtent({_width, _height}, level)));
+    }
+
+    auto offset = size_t{};
+    loadRawTextureData(levelSizes, [&](glm::u32, std::span<std::byte> dst) {
+        assert(offset + dst.size() <= blocks.size());
+        std::memcpy(dst.data(), blocks.data() + offset, dst.size());
+        offset += dst.size();
+    });
+}
+
+// All levels share one staging allocation, each placed at the staging alignment of the format.
+// Levels left out are generated when only level 0 is given.
+void Texture2D::loadRawTextureData(std::span<const vk::DeviceSize> levelSizes, const std::function<void(glm::u32, std::span<std::byte>)>& read) {
+    assert(!levelSizes.empty() && levelSizes.size() <= _mipCount);
+
+    const auto alignment = GetStagingAlignment(_format);
+    auto copies = std::vector<vk::BufferImageCopy>{};
+    auto offsets = std::vector<vk::DeviceSize>{};
+    auto size = vk::DeviceSize{};
+    for (glm::u32 level = 0; level < levelSizes.size(); ++level) {
+        size = (size + alignment - 1) / alignment * alignment;
+        copies.emplace_back(GetCopyRegion(_format, {.extent = GetMipExtent({_width, _height}, level)}, size, level));
+        offsets.emplace_back(size);
+        size += levelSizes[level];
+    }
+
+    _stage(size, copies, [&](std::byte* ptr) {
+        for (glm::u32 level = 0; level < levelSizes.size(); ++level) {
+            read(level, std::span(ptr + offsets[level], levelSizes[level]));
+        }
+    });
+}
+
+// Every level is encoded straight into the staging memory, which is only ever written. The
+// chain below level 0 is box filtered from the uncompressed pixels.
+void Texture2D::_uploadCompressed(std::span<const glm::u8vec4> pixels) {
+    const auto format = *GetBlockFormat(_format);
+    assert(pixels.size() == static_cast<size_t>(_width) * _height);
+
+    auto copies = std::vector<vk::BufferImageCopy>{};
+    auto offsets = std::vector<vk::DeviceSize>{};
+    auto size = vk::DeviceSize{};
+    for (glm::u32 level = 0; level < _mipCount; ++level) {
+        const auto extent = GetMipExtent({_width, _height}, level);
+        copies.emplace_back(GetCopyRegion(_format, {.extent = extent}, size, level));
+        offsets.emplace_back(size);
+        size += GetLevelSize(_format, extent);
+    }
+
+    _stage(size, copies, [&](std::byte* ptr) {
+        auto level = pixels;
+        auto current = std::vector<glm::u8vec4>{};
+        auto next = std::vector<glm::u8vec4>{};
+        for (glm::u32 i = 0; i < _mipCount; ++i) {
+            const auto extent = GetMipExtent({_width, _height}, i);
+            CompressPixels(level, extent, format, std::span(ptr + offsets[i], GetLevelSize(_format, extent)));
+            if (i + 1 == _mipCount) {
+                break;
+            }
+            const auto nextExtent = GetMipExtent(extent, 1);
+            next.resize(static_cast<size_t>(nextExtent.x) * nextExtent.y);
+            DownsamplePixels(level, extent, next);
+            std::swap(current, next);
+            level = current;
+        }
+    });
+}
+
+// Every setPixels ends here with the copies of level 0, the chain below it is added either by
+// the CPU before staging or by blits after the copy.
+void Texture2D::_upload(vk::DeviceSize size, std::span<vk::BufferImageCopy> regions, const std::function<void(std::byte*)>& fill) {
+    if (_mipCount > 1 && !_blitMips) {
+        assert(regions.size() == 1 && (regions[0].imageExtent == vk::Extent3D{_width, _height, 1}));
+        _uploadWithMips(size, fill);
+        return;
+    }
+    _stage(size, regions, fill);
+}
+
+// Level 0 is filled into scratch memory rather than staging, which may be uncached to read
+// back from while filtering, and the whole chain is then staged with one copy per level.
+void Texture2D::_uploadWithMips(vk::DeviceSize size, const std::function<void(std::byte*)>& fill) {
+    const auto extent = glm::uvec2(_width, _height);
+    const auto texelSize = vk::DeviceSize{GetFormatInfo(_format).size};
+    assert(size == GetLevelSize(_format, extent));
+
+    auto copies = std::vector<vk::BufferImageCopy>{};
+    auto chainSize = vk::DeviceSize{};
+    for (glm::u32 level = 0; level < _mipCount; ++level) {
+        const auto levelExtent = GetMipExtent(extent, level);
+        copies.emplace_back(GetCopyRegion(_format, {.extent = levelExtent}, chainSize, level));
+        chainSize += GetLevelSize(_format, levelExtent);
+    }
+
+    auto chain = std::vector<std::byte>(chainSize);
+    fill(chain.data());
+    switch (texelSize) {
+        case sizeof(glm::u8vec4):
+            GenerateMips<glm::u8vec4>(chain.data(), extent, _mipCount);
+            break;
+        case sizeof(glm::u16vec4):
+            GenerateMips<glm::u16vec4>(chain.data(), extent, _mipCount);
+            break;
+        case sizeof(glm::vec4):
+            GenerateMips<glm::vec4>(chain.data(), extent, _mipCount);
+            break;
+        default:
+            assert(false && "unsupported texel size");
+            break;
+    }
+
+    _stage(chainSize, copies, [&](std::byte* ptr) {
+        std::memcpy(ptr, chain.data(), chain.size());
+    });
+}
+
+// Staging space comes from the device's ring and the copy is recorded into its upload batch,
+// which is submitted ahead of the frame that samples the texture. Uploads larger than the ring
+// fall back to a temporary staging buffer and wait for the copy.
+//
+// The first upload of a texture runs on the transfer queue when there is one. Later uploads stay
+// on the graphics queue, which already orders them after the frames still sampling the image,
+// and so do blitted chains since blits need a graphics queue.
+void Texture2D::_stage(vk::DeviceSize size, std::span<vk::BufferImageCopy> regions, const std::function<void(std::byte*)>& fill) {
+    auto& ring = GetGfxDevice().getStagingRing();
+    if (const auto allocation = ring.allocate(size, GetStagingAlignment(_format))) {
+        fill(allocation->data);
+        for (auto& region : regions) {
+            region.bufferOffset += allocation->offset;
+        }
+        const auto vk_texture = static_cast<VulkanTexture*>(impl.get());
+        if (ring.hasTransferQueue() && vk_texture->layout == vk::ImageLayout::eUndefined && !_generatesMips(regions)) {
+            _recordTransferCopy(ring, allocation->buffer, regions);
+        } else {
+            _recordCopy(ring.getGraphicsCommandBuffer(), allocation->buffer, regions);
+        }
+        return;
+    }
+
+    // Uploads recorded earlier must still reach the queue first.
+    ring.flush();
+
+    auto stagingBuffer = GraphicsBuffer(GraphicsBuffer::Target::CopySrc, static_cast<int>(size));
+    fill(stagingBuffer.map().data());
+
+    auto vk_stagingBuffer = static_cast<VulkanGraphicsBuffer*>(stagingBuffer.getNativeBufferPtr())->buffer;
+
+    auto pool = Graphics::CreateCommandPool();
+    auto cmd = pool.allocate();
+    (*cmd).begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    _recordCopy(*cmd, vk_stagingBuffer, regions);
+    (*cmd).end();
+    Graphics::WaitOnGraphicsFence(Graphics::ExecuteCommandBuffer(cmd));
+    pool.free(cmd);
+}
+
+// Partial updates have to keep the rest of the image, so only a copy that covers the whole
+// of level 0 may start from eUndefined, the levels below are always rewritten. Either way the
+// transition waits for the fragment shader reads of the frames that were submitted before.
+void Texture2D::_recordCopy(vk::CommandBuffer cmd, vk::Buffer buffer, std::span<const vk::BufferImageCopy> regions) {
+    auto vk_texture = static_cast<VulkanTexture*>(impl.get());
+
+    const auto discard = std::ranges::any_of(regions, [this](const vk::BufferImageCopy& region) {
+        return region.imageSubresource.mipLevel == 0
+            && region.imageOffset == vk::Offset3D{}
+            && region.imageExtent == vk::Extent3D{_width, _height, 1};
+    });
 
     const auto copy_barrier = vk::ImageMemoryBarrier{
         .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
-        .oldLayout = vk::ImageLayout::eUndefined,
+        .oldLayout = discard ? vk::ImageLayout::eUndefined : vk_texture->layout,
         .newLayout = vk::ImageLayout::eTransferDstOptimal,
         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
         .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
         .image = getImage(),
         .subresourceRange = {
             .aspectMask = vk::ImageAspectFlagBits::eColor,
-            .levelCount = 1,
+            .levelCount = _mipCount,
             .layerCount = 1
         }
     };
 
-    const auto region = vk::BufferImageCopy{
-        .imageSubresource = {
-            .aspectMask = vk::ImageAspectFlagBits::eColor,
-            .layerCount = 1
-        },
-        .imageExtent = {
-            .width = _width,
-            .height = _height,
-            .depth = 1
-        }
-    };
-
     const auto use_barrier = vk::ImageMemoryBarrier{
         .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
         .dstAccessMask = vk::AccessFlagBits::eShaderRead,
@@ -366,24 +496,151 @@ void Texture2D::setPixels(std::span<const glm::u8vec4> pixels) {
         .image = getImage(),
         .subresourceRange = {
             .aspectMask = vk::ImageAspectFlagBits::eColor,
-            .levelCount = 1,
+            .levelCount = _mipCount,
             .layerCount = 1
         }
     };
 
-    auto vk_stagingBuffer = static_cast<VulkanGraphicsBuffer*>(stagingBuffer.getNativeBufferPtr())->buffer;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, {copy_barrier});
+    cmd.copyBufferToImage(buffer, getImage(), vk::ImageLayout::eTransferDstOptimal, static_cast<uint32_t>(regions.size()), regions.data());
+    if (_generatesMips(regions)) {
+        _recordMipChain(cmd);
+    } else {
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, {use_barrier});
+    }
 
-    auto fence = Graphics::CreateGraphicsFence();
-    auto pool = Graphics::CreateCommandPool();
-    auto cmd = pool.allocate();
-    (*cmd).begin({.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
-    (*cmd).pipelineBarrier(vk::PipelineStageFlagBits::eHost, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, {copy_barrier});
-    (*cmd).copyBufferToImage(vk_stagingBuffer, getImage(), vk::ImageLayout::eTransferDstOptimal, {region});
-    (*cmd).pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, {use_barrier});
-    (*cmd).end();
-    Graphics::ExecuteCommandBuffer(cmd, fence);
-    Graphics::WaitOnGraphicsFence(fence);
-    pool.free(cmd);
+    vk_texture->layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+}
+
+// Blits rebuild the chain whenever an upload brings level 0 alone.
+auto Texture2D::_generatesMips(std::span<const vk::BufferImageCopy> regions) const -> bool {
+    return _blitMips && std::ranges::all_of(regions, [](const vk::BufferImageCopy& region) {
+        return region.imageSubresource.mipLevel == 0;
+    });
+}
+
+// Every level is blitted from the one above it, which is moved to eTransferSrcOptimal first. All
+// levels come out in eShaderReadOnlyOptimal.
+void Texture2D::_recordMipChain(vk::CommandBuffer cmd) {
+    const auto extent = glm::uvec2(_width, _height);
+
+    const auto barrier = [this](glm::u32 level, glm::u32 count, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, vk::AccessFlags srcAccess, vk::AccessFlags dstAccess) {
+        return vk::ImageMemoryBarrier{
+            .srcAccessMask = srcAccess,
+            .dstAccessMask = dstAccess,
+            .oldLayout = oldLayout,
+            .newLayout = newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = getImage(),
+            .subresourceRange = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = level,
+                .levelCount = count,
+                .layerCount = 1
+            }
+        };
+    };
+
+    for (glm::u32 level = 1; level < _mipCount; ++level) {
+        const auto srcExtent = GetMipExtent(extent, level - 1);
+        const auto dstExtent = GetMipExtent(extent, level);
+
+        const auto src_barrier = barrier(
+            level - 1, 1,
+            vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+            vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead
+        );
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, {src_barrier});
+
+        const auto blit = vk::ImageBlit{
+            .srcSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = level - 1,
+                .layerCount = 1
+            },
+            .srcOffsets = std::array{
+                vk::Offset3D{},
+                vk::Offset3D{static_cast<int32_t>(srcExtent.x), static_cast<int32_t>(srcExtent.y), 1}
+            },
+            .dstSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = level,
+                .layerCount = 1
+            },
+            .dstOffsets = std::array{
+                vk::Offset3D{},
+                vk::Offset3D{static_cast<int32_t>(dstExtent.x), static_cast<int32_t>(dstExtent.y), 1}
+            }
+        };
+        cmd.blitImage(getImage(), vk::ImageLayout::eTransferSrcOptimal, getImage(), vk::ImageLayout::eTransferDstOptimal, {blit}, vk::Filter::eLinear);
+    }
+
+    const auto use_barriers = std::array{
+        barrier(
+            0, _mipCount - 1,
+            vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead
+        ),
+        barrier(
+            _mipCount - 1, 1,
+            vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead
+        )
+    };
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, use_barriers);
+}
+
+// The copy and the release half of the ownership transfer go to the transfer queue, the acquire
+// half to the graphics side of the same batch. Both halves carry the same layout transition.
+void Texture2D::_recordTransferCopy(VulkanStagingRing& ring, vk::Buffer buffer, std::span<const vk::BufferImageCopy> regions) {
+    auto vk_texture = static_cast<VulkanTexture*>(impl.get());
+
+    const auto subresourceRange = vk::ImageSubresourceRange{
+        .aspectMask = vk::ImageAspectFlagBits::eColor,
+        .levelCount = _mipCount,
+        .layerCount = 1
+    };
+
+    const auto copy_barrier = vk::ImageMemoryBarrier{
+        .dstAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eUndefined,
+        .newLayout = vk::ImageLayout::eTransferDstOptimal,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = getImage(),
+        .subresourceRange = subresourceRange
+    };
+
+    const auto release_barrier = vk::ImageMemoryBarrier{
+        .srcAccessMask = vk::AccessFlagBits::eTransferWrite,
+        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+        .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        .srcQueueFamilyIndex = ring.getTransferFamily(),
+        .dstQueueFamilyIndex = ring.getGraphicsFamily(),
+        .image = getImage(),
+        .subresourceRange = subresourceRange
+    };
+
+    const auto acquire_barrier = vk::ImageMemoryBarrier{
+        .dstAccessMask = vk::AccessFlagBits::eShaderRead,
+        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+        .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        .srcQueueFamilyIndex = ring.getTransferFamily(),
+        .dstQueueFamilyIndex = ring.getGraphicsFamily(),
+        .image = getImage(),
+        .subresourceRange = subresourceRange
+    };
+
+    auto transfer = ring.getTransferCommandBuffer();
+    transfer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, {copy_barrier});
+    transfer.copyBufferToImage(buffer, getImage(), vk::ImageLayout::eTransferDstOptimal, static_cast<uint32_t>(regions.size()), regions.data());
+    transfer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, {}, {release_barrier});
+
+    auto graphics = ring.getGraphicsCommandBuffer();
+    graphics.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, {acquire_barrier});
+
+    vk_texture->layout = vk::ImageLayout::eShaderReadOnlyOptimal;
 }
 
 void RenderTexture::Dispose::operator()(void* texture) {
@@ -2,12 +2,18 @@
 
 #include <span>
 #include <memory>
+#include <functional>
 #include <glm/glm.hpp>
 
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 
 #include "TextureData.hpp"
+#include "SamplerDescriptor.hpp"
+#include "TextureCompression.hpp"
+#include "TextureConversion.hpp"
+
+struct VulkanStagingRing;
 
 enum class GraphicsFormat {
 };
@@ -18,9 +24,14 @@ struct Texture {
     Texture() = default;
     Texture(VkImage image, VkImageView view, VkSampler sampler, VmaAllocation allocation);
 
+    // Defragmentation can move a texture to a new image, the handles are for the frame being
+    // recorded only.
     auto getImage() const -> vk::Image;
     auto getSampler() const -> vk::Sampler;
     auto getImageView() const -> vk::ImageView;
+    auto getNativeTexturePtr() const -> void* {
+        return impl.get();
+    }
 
 private:
     struct Dispose {
@@ -33,11 +44,32 @@ struct Texture2D : protected Texture {
     using Texture::getImage;
     using Texture::getSampler;
     using Texture::getImageView;
+    using Texture::getNativeTexturePtr;
 
     Texture2D() = default;
-    Texture2D(glm::u32 width, glm::u32 height, vk::Format format);
+    // With mipChain the full chain down to 1x1 is allocated and rebuilt from level 0 on every
+    // upload, by linear blits where the format allows them and on the CPU otherwise.
+    Texture2D(glm::u32 width, glm::u32 height, vk::Format format, bool mipChain = false);
+    // For chains that stop short of 1x1, as stored by some containers.
+    static auto CreateWithMipCount(glm::u32 width, glm::u32 height, vk::Format format, glm::u32 mipCount) -> Texture2D;
+    // Whether a chain can be blitted on the GPU, raw uploads cannot fall back to the CPU.
+    static auto CanGenerateMips(vk::Format format) -> bool;
+    // Whether blocks encoded ahead of time can be uploaded. Without BC sampling on the device,
+    // BC textures are created as RGBA8 and only take setPixels.
+    static auto CanUploadRaw(vk::Format format) -> bool;
 
     void setPixels(std::span<const glm::u8vec4> pixels);
+    void setPixels(const TextureData& data);
+    void setPixels(const TextureData& data, std::span<const TextureRegion> regions);
+    // Uploads the regions marked dirty on the data and clears them, the next call only sends
+    // what was marked since.
+    void setDirtyPixels(TextureData& data);
+    void setPixels(const HDRTextureData& data, const TextureConversion& conversion = {});
+    // Takes blocks encoded ahead of time, for all mip levels, see CanUploadRaw. Block-compressed
+    // textures also accept every setPixels, which encodes on the CPU first.
+    void setCompressedPixels(std::span<const std::byte> blocks);
+    // Data already in the texture's format, read straight into staging memory level by level.
+    void loadRawTextureData(std::span<const vk::DeviceSize> levelSizes, const std::function<void(glm::u32, std::span<std::byte>)>& read);
 
     auto width() const -> glm::u32 {
         return _width;
@@ -45,10 +77,53 @@ struct Texture2D : protected Texture {
     auto height() const -> glm::u32 {
         return _height;
     }
+    auto format() const -> vk::Format {
+        return _format;
+    }
+    auto mipmapCount() const -> glm::u32 {
+        return _mipCount;
+    }
+
+    // Sampler state defaults to point sampling, or trilinear with a mip chain. Materials see a
+    // change on their next SetTexture.
+    auto filterMode() const -> FilterMode {
+        return _sampler.filterMode;
+    }
+    auto wrapMode() const -> TextureWrapMode {
+        return _sampler.wrapMode;
+    }
+    auto anisoLevel() const -> glm::u32 {
+        return _sampler.anisoLevel;
+    }
+    auto mipMapBias() const -> glm::f32 {
+        return _sampler.mipMapBias;
+    }
+    auto samplerDescriptor() const -> const SamplerDescriptor& {
+        return _sampler;
+    }
+    void setFilterMode(FilterMode filterMode);
+    void setWrapMode(TextureWrapMode wrapMode);
+    void setAnisoLevel(glm::u32 anisoLevel);
+    void setMipMapBias(glm::f32 mipMapBias);
+    void setSamplerDescriptor(const SamplerDescriptor& descriptor);
 
 private:
+    void _create(glm::u32 width, glm::u32 height, vk::Format format, glm::u32 mipCount);
+    auto _generatesMips(std::span<const vk::BufferImageCopy> regions) const -> bool;
+    void _upload(vk::DeviceSize size, std::span<vk::BufferImageCopy> regions, const std::function<void(std::byte*)>& fill);
+    void _uploadWithMips(vk::DeviceSize size, const std::function<void(std::byte*)>& fill);
+    void _uploadCompressed(std::span<const glm::u8vec4> pixels);
+    void _stage(vk::DeviceSize size, std::span<vk::BufferImageCopy> regions, const std::function<void(std::byte*)>& fill);
+    void _recordCopy(vk::CommandBuffer cmd, vk::Buffer buffer, std::span<const vk::BufferImageCopy> regions);
+    void _recordTransferCopy(VulkanStagingRing& ring, vk::Buffer buffer, std::span<const vk::BufferImageCopy> regions);
+    void _recordMipChain(vk::CommandBuffer cmd);
+
     glm::u32 _width{};
     glm::u32 _height{};
+    vk::Format _format{};
+    glm::u32 _mipCount = 1;
+    bool _blitMips = false;
+    SamplerDescriptor _sampler{};
 };
 
 struct RenderTextureDescriptor {
@@ -0,0 +1,356 @@
+#include "TextureCompression.hpp"
+#include "ThreadPool.hpp"
+
+#include <array>
+#include <limits>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLAZE_TEXTURE_COMPRESSION_SSE2
+#endif
+
+using Block = std::array<glm::u8vec4, 16>;
+
+static void LoadBlock(std::span<const glm::u8vec4> src, glm::uvec2 extent, glm::u32 bx, glm::u32 by, Block& block) {
+    for (glm::u32 y = 0; y < 4; ++y) {
+        const auto sy = std::min(by * 4 + y, extent.y - 1);
+        for (glm::u32 x = 0; x < 4; ++x) {
+            const auto sx = std::min(bx * 4 + x, extent.x - 1);
+            block[y * 4 + x] = src[static_cast<size_t>(sy) * extent.x + sx];
+        }
+    }
+}
+
+static void GetBounds(const Block& block, glm::u8vec4& min, glm::u8vec4& max) {
+#if defined(BLAZE_TEXTURE_COMPRESSION_SSE2)
+    // The block is four registers, folding them and then the lanes leaves the per-channel bounds.
+    const auto* data = reinterpret_cast<const __m128i*>(block.data());
+    auto lo = _mm_min_epu8(_mm_min_epu8(_mm_loadu_si128(data + 0), _mm_loadu_si128(data + 1)), _mm_min_epu8(_mm_loadu_si128(data + 2), _mm_loadu_si128(data + 3)));
+    auto hi = _mm_max_epu8(_mm_max_epu8(_mm_loadu_si128(data + 0), _mm_loadu_si128(data + 1)), _mm_max_epu8(_mm_loadu_si128(data + 2), _mm_loadu_si128(data + 3)));
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+    lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+    hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+
+    const auto packedMin = static_cast<glm::u32>(_mm_cvtsi128_si32(lo));
+    const auto packedMax = static_cast<glm::u32>(_mm_cvtsi128_si32(hi));
+    std::memcpy(&min, &packedMin, sizeof(min));
+    std::memcpy(&max, &packedMax, sizeof(max));
+#else
+    min = block[0];
+    max = block[0];
+    for (const auto& pixel : block) {
+        min = glm::min(min, pixel);
+        max = glm::max(max, pixel);
+    }
+#endif
+}
+
+// Bounding boxes always run along the main diagonal. Swapping the bounds of the channels that
+// fall with the widest one picks the diagonal that follows the colors instead.
+static void SelectDiagonal(const Block& block, glm::u32 channels, glm::u8vec4& min, glm::u8vec4& max) {
+    const auto center = (glm::ivec4(min) + glm::ivec4(max)) / 2;
+
+    auto axis = glm::u32{0};
+    for (glm::u32 c = 1; c < channels; ++c) {
+        if (max[c] - min[c] > max[axis] - min[axis]) {
+            axis = c;
+        }
+    }
+
+    auto covariance = glm::ivec4(0);
+    for (const auto& pixel : block) {
+        const auto d = glm::ivec4(pixel) - center;
+        covariance += d * d[axis];
+    }
+    for (glm::u32 c = 0; c < channels; ++c) {
+        if (covariance[c] < 0) {
+            std::swap(min[c], max[c]);
+        }
+    }
+}
+
+// Moves the bounds in by 1/16 of the range, which lowers the error of the points in between.
+static void Inset(glm::u8vec4& a, glm::u8vec4& b, glm::u32 channels) {
+    for (glm::u32 c = 0; c < channels; ++c) {
+        const auto inset = (static_cast<int>(b[c]) - static_cast<int>(a[c])) / 16;
+        a[c] = static_cast<glm::u8>(a[c] + inset);
+        b[c] = static_cast<glm::u8>(b[c] - inset);
+    }
+}
+
+template <size_t N>
+static auto FindNearest(const glm::u8vec4& pixel, const std::array<glm::ivec4, N>& palette, glm::u32 channels) -> glm::u32 {
+    auto best = glm::u32{0};
+    auto bestError = std::numeric_limits<int>::max();
+    for (glm::u32 i = 0; i < N; ++i) {
+        auto error = 0;
+        for (glm::u32 c = 0; c < channels; ++c) {
+            const auto d = static_cast<int>(pixel[c]) - palette[i][c];
+            error += d * d;
+        }
+        if (error < bestError) {
+            best = i;
+            bestError = error;
+        }
+    }
+    return best;
+}
+
+static auto To565(const glm::u8vec4& color) -> glm::u16 {
+    return static_cast<glm::u16>(((color.x * 31 + 127) / 255) << 11 | ((color.y * 63 + 127) / 255) << 5 | ((color.z * 31 + 127) / 255));
+}
+
+static auto From565(glm::u16 color) -> glm::ivec4 {
+    const auto r = (color >> 11) & 31;
+    const auto g = (color >> 5) & 63;
+    const auto b = color & 31;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255};
+}
+
+// Always the four color mode, which is also the only one BC3 color blocks know.
+static void EncodeColorBlock(const Block& block, std::byte* out) {
+    auto min = glm::u8vec4{};
+    auto max = glm::u8vec4{};
+    GetBounds(block, min, max);
+    SelectDiagonal(block, 3, min, max);
+    Inset(min, max, 3);
+
+    auto c0 = To565(max);
+    auto c1 = To565(min);
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    auto indices = glm::u32{0};
+    if (c0 != c1) {
+        const auto e0 = From565(c0);
+        const auto e1 = From565(c1);
+        const auto palette = std::array{e0, e1, (e0 * 2 + e1) / 3, (e0 + e1 * 2) / 3};
+        for (glm::u32 i = 0; i < 16; ++i) {
+            indices |= FindNearest(block[i], palette, 3) << (i * 2);
+        }
+    }
+
+    std::memcpy(out + 0, &c0, 2);
+    std::memcpy(out + 2, &c1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+// Blocks with a pixel below half alpha use the three color mode, where index 3 is transparent
+// black. The endpoints come from the opaque pixels only and have to be stored in order.
+static void EncodeColorAlphaBlock(const Block& block, std::byte* out) {
+    auto opaque = Block{};
+    auto count = glm::u32{0};
+    for (const auto& pixel : block) {
+        if (pixel.w >= 128) {
+            opaque[count++] = pixel;
+        }
+    }
+    if (count == 16) {
+        EncodeColorBlock(block, out);
+        return;
+    }
+
+    auto c0 = glm::u16{0};
+    auto c1 = glm::u16{0};
+    auto indices = ~glm::u32{0};
+    if (count != 0) {
+        // Repeating an opaque pixel keeps the bounds to the opaque ones.
+        std::fill(opaque.begin() + count, opaque.end(), opaque[0]);
+
+        auto min = glm::u8vec4{};
+        auto max = glm::u8vec4{};
+        GetBounds(opaque, min, max);
+        SelectDiagonal(opaque, 3, min, max);
+
+        c0 = To565(min);
+        c1 = To565(max);
+        if (c0 > c1) {
+            std::swap(c0, c1);
+        }
+
+        const auto e0 = From565(c0);
+        const auto e1 = From565(c1);
+        const auto palette = std::array{e0, e1, (e0 + e1) / 2};
+        for (glm::u32 i = 0; i < 16; ++i) {
+            if (block[i].w >= 128) {
+                indices &= ~(glm::u32{3} << (i * 2)) | FindNearest(block[i], palette, 3) << (i * 2);
+            }
+        }
+    }
+
+    std::memcpy(out + 0, &c0, 2);
+    std::memcpy(out + 2, &c1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+// One channel in the eight value mode with 3-bit indices.
+static void EncodeChannelBlock(const Block& block, glm::u32 channel, std::byte* out) {
+    auto e0 = block[0][channel];
+    auto e1 = block[0][channel];
+    for (const auto& pixel : block) {
+        e0 = std::max(e0, pixel[channel]);
+        e1 = std::min(e1, pixel[channel]);
+    }
+
+    auto bits = glm::u64{0};
+    if (e0 != e1) {
+        auto palette = std::array<glm::ivec4, 8>{};
+        palette[0].x = e0;
+        palette[1].x = e1;
+        for (glm::u32 i = 1; i < 7; ++i) {
+            palette[i + 1].x = ((7 - i) * e0 + i * e1) / 7;
+        }
+        for (glm::u32 i = 0; i < 16; ++i) {
+            const auto value = glm::u8vec4(block[i][channel], 0, 0, 0);
+            bits |= static_cast<glm::u64>(FindNearest(value, palette, 1)) << (i * 3);
+        }
+    }
+
+    out[0] = static_cast<std::byte>(e0);
+    out[1] = static_cast<std::byte>(e1);
+    for (glm::u32 i = 0; i < 6; ++i) {
+        out[2 + i] = static_cast<std::byte>(bits >> (i * 8));
+    }
+}
+
+// Little endian bit stream over one 128-bit block.
+struct BlockWriter {
+    std::array<glm::u64, 2> bits{};
+    glm::u32 position = 0;
+
+    void write(glm::u64 value, glm::u32 count) {
+        for (glm::u32 i = 0; i < count; ++i, ++position) {
+            bits[position / 64] |= ((value >> i) & 1) << (position % 64);
+        }
+    }
+};
+
+// Mode 6 of BC7: one subset, RGBA endpoints of 7 bits plus a shared low bit each, 4-bit indices.
+static void EncodeBC7Block(const Block& block, std::byte* out) {
+    static constexpr auto kWeights = std::array{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    auto min = glm::u8vec4{};
+    auto max = glm::u8vec4{};
+    GetBounds(block, min, max);
+    SelectDiagonal(block, 4, min, max);
+    Inset(min, max, 4);
+
+    // Picks the p-bit with the lower error and the 7-bit values that go with it.
+    const auto quantize = [](const glm::u8vec4& color, glm::u32& pbit) {
+        auto best = glm::ivec4{};
+        auto bestError = std::numeric_limits<int>::max();
+        for (glm::u32 p = 0; p < 2; ++p) {
+            auto q = glm::ivec4{};
+            auto error = 0;
+            for (glm::u32 c = 0; c < 4; ++c) {
+                q[c] = std::clamp((static_cast<int>(color[c]) - static_cast<int>(p) + 1) >> 1, 0, 127);
+                const auto d = ((q[c] << 1) | static_cast<int>(p)) - color[c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                best = q;
+                bestError = error;
+                pbit = p;
+            }
+        }
+        return best;
+    };
+
+    auto pbits = std::array<glm::u32, 2>{};
+    auto endpoints = std::array{quantize(min, pbits[0]), quantize(max, pbits[1])};
+
+    const auto e0 = endpoints[0] * 2 + static_cast<int>(pbits[0]);
+    const auto e1 = endpoints[1] * 2 + static_cast<int>(pbits[1]);
+    auto palette = std::array<glm::ivec4, 16>{};
+    for (glm::u32 i = 0; i < 16; ++i) {
+        palette[i] = (e0 * (64 - kWeights[i]) + e1 * kWeights[i] + 32) >> 6;
+    }
+
+    auto indices = std::array<glm::u32, 16>{};
+    for (glm::u32 i = 0; i < 16; ++i) {
+        indices[i] = FindNearest(block[i], palette, 4);
+    }
+
+    // The first index is stored without its top bit, so it has to be below 8.
+    if (indices[0] >= 8) {
+        std::swap(endpoints[0], endpoints[1]);
+        std::swap(pbits[0], pbits[1]);
+        for (auto& index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    auto writer = BlockWriter{};
+    writer.write(1 << 6, 7);
+    for (glm::u32 c = 0; c < 4; ++c) {
+        writer.write(static_cast<glm::u64>(endpoints[0][c]), 7);
+        writer.write(static_cast<glm::u64>(endpoints[1][c]), 7);
+    }
+    writer.write(pbits[0], 1);
+    writer.write(pbits[1], 1);
+    writer.write(indices[0], 3);
+    for (glm::u32 i = 1; i < 16; ++i) {
+        writer.write(indices[i], 4);
+    }
+    std::memcpy(out, writer.bits.data(), 16);
+}
+
+static void EncodeBlock(const Block& block, BlockFormat format, std::byte* out) {
+    switch (format) {
+        case BlockFormat::BC1:
+            EncodeColorBlock(block, out);
+            break;
+        case BlockFormat::BC1A:
+            EncodeColorAlphaBlock(block, out);
+            break;
+        case BlockFormat::BC3:
+            EncodeChannelBlock(block, 3, out);
+            EncodeColorBlock(block, out + 8);
+            break;
+        case BlockFormat::BC4:
+            EncodeChannelBlock(block, 0, out);
+            break;
+        case BlockFormat::BC5:
+            EncodeChannelBlock(block, 0, out);
+            EncodeChannelBlock(block, 1, out + 8);
+            break;
+        case BlockFormat::BC7:
+            EncodeBC7Block(block, out);
+            break;
+    }
+}
+
+void CompressPixels(std::span<const glm::u8vec4> src, glm::uvec2 extent, BlockFormat format, std::span<std::byte> dst, glm::u32 threadCount) {
+    assert(src.size() == static_cast<size_t>(extent.x) * extent.y && dst.size() == GetCompressedSize(extent, format));
+
+    const auto blocks = GetBlockCount(extent);
+    const auto blockSize = GetBlockSize(format);
+    const auto encodeRow = [&](glm::u32 by) {
+        auto block = Block{};
+        for (glm::u32 bx = 0; bx < blocks.x; ++bx) {
+            LoadBlock(src, extent, bx, by, block);
+            EncodeBlock(block, format, &dst[(static_cast<size_t>(by) * blocks.x + bx) * blockSize]);
+        }
+    };
+
+    if (threadCount == 1 || blocks.y == 1) {
+        for (glm::u32 by = 0; by < blocks.y; ++by) {
+            encodeRow(by);
+        }
+        return;
+    }
+
+    auto pool = ThreadPool{threadCount != 0 ? threadCount : std::thread::hardware_concurrency()};
+    for (glm::u32 by = 0; by < blocks.y; ++by) {
+        pool.jobs.emplace([&encodeRow, by] {
+            encodeRow(by);
+        });
+    }
+    pool.start();
+    pool.wait();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Block formats the CPU encoder can produce. BC1 is opaque RGB and BC1A keeps 1-bit alpha,
+// BC3 adds a BC4 alpha block, BC4 and BC5 hold the red and the red/green channels, BC7 is RGBA
+// with the quality of mode 6.
+enum class BlockFormat {
+    BC1,
+    BC1A,
+    BC3,
+    BC4,
+    BC5,
+    BC7
+};
+
+inline auto GetBlockSize(BlockFormat format) -> size_t {
+    return format == BlockFormat::BC1 || format == BlockFormat::BC1A || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+inline auto GetBlockCount(glm::uvec2 extent) -> glm::uvec2 {
+    return (extent + 3u) / 4u;
+}
+
+inline auto GetCompressedSize(glm::uvec2 extent, BlockFormat format) -> size_t {
+    const auto blocks = GetBlockCount(extent);
+    return static_cast<size_t>(blocks.x) * blocks.y * GetBlockSize(format);
+}
+
+// Encodes linear pixels into 4x4 blocks in row-major block order, edge blocks repeat the last
+// row and column. Rows of blocks are spread over threadCount workers, 0 uses every core and 1
+// encodes on the calling thread. dst must hold GetCompressedSize bytes.
+void CompressPixels(std::span<const glm::u8vec4> src, glm::uvec2 extent, BlockFormat format, std::span<std::byte> dst, glm::u32 threadCount = 0);
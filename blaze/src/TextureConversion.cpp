@@ -0,0 +1,265 @@
+#include "TextureConversion.hpp"
+
+#include <bit>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLAZE_TEXTURE_CONVERSION_SSE2
+#endif
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+static constexpr size_t kSRGBTableSize = 4096;
+
+// Encoding through a table indexed by the 12-bit linear value keeps pow out of the loop and
+// is exact to 8 bits everywhere except the darkest few codes.
+static auto GetSRGBTable() -> const std::array<glm::u8, kSRGBTableSize>& {
+    static const auto table = [] {
+        auto table = std::array<glm::u8, kSRGBTableSize>{};
+        for (size_t i = 0; i < table.size(); ++i) {
+            const auto c = static_cast<glm::f32>(i) / static_cast<glm::f32>(kSRGBTableSize - 1);
+            const auto s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+            table[i] = static_cast<glm::u8>(s * 255.0f + 0.5f);
+        }
+        return table;
+    }();
+    return table;
+}
+
+// NaN goes to zero, as maxps does in the SIMD path, before it can reach a float to int
+// conversion. The test is on the bits since -ffast-math folds std::isnan away.
+static auto Saturate(glm::f32 x) -> glm::f32 {
+    if ((std::bit_cast<glm::u32>(x) & 0x7FFFFFFFu) > 0x7F800000u) {
+        return 0.0f;
+    }
+    return std::min(std::max(x, 0.0f), 1.0f);
+}
+
+// x / (1 + x) is NaN for +inf, which belongs at 1. As in Saturate the test is on the bits.
+// The quotient is taken in double, like in the SIMD path: -ffast-math lets float vector
+// division become a reciprocal estimate, a double one rounds back to the exact float quotient.
+static auto Reinhard(glm::f32 x) -> glm::f32 {
+    if (std::bit_cast<glm::u32>(x) == 0x7F800000u) {
+        return 1.0f;
+    }
+    return static_cast<glm::f32>(static_cast<double>(x) / static_cast<double>(1.0f + x));
+}
+
+// Quantization adds 0.5 and truncates, the SIMD path rounds the same way.
+static auto ConvertPixel(const glm::vec4& pixel, const TextureConversion& conversion, const std::array<glm::u8, kSRGBTableSize>& table) -> glm::u8vec4 {
+    auto rgb = glm::vec3(pixel) * conversion.exposure;
+    if (conversion.toneMapping == ToneMapping::Reinhard) {
+        rgb = glm::vec3(Reinhard(rgb.x), Reinhard(rgb.y), Reinhard(rgb.z));
+    }
+    rgb = glm::vec3(Saturate(rgb.x), Saturate(rgb.y), Saturate(rgb.z));
+
+    const auto a = static_cast<glm::u8>(Saturate(pixel.w) * 255.0f + 0.5f);
+    if (conversion.sRGB) {
+        const auto i = glm::uvec3(rgb * static_cast<glm::f32>(kSRGBTableSize - 1) + 0.5f);
+        return {table[i.x], table[i.y], table[i.z], a};
+    }
+    return glm::u8vec4(glm::u8vec3(rgb * 255.0f + 0.5f), a);
+}
+
+void ConvertPixels(std::span<const glm::vec4> src, std::span<glm::u8vec4> dst, const TextureConversion& conversion) {
+    assert(src.size() == dst.size());
+
+    const auto& table = GetSRGBTable();
+
+    size_t i = 0;
+#if defined(BLAZE_TEXTURE_CONVERSION_SSE2)
+    const auto zero = _mm_setzero_ps();
+    const auto one = _mm_set1_ps(1.0f);
+    const auto half = _mm_set1_ps(0.5f);
+    const auto colorMask = _mm_setr_ps(1.0f, 1.0f, 1.0f, 0.0f);
+    const auto infinity = _mm_set1_epi32(0x7F800000);
+    const auto exposure = _mm_setr_ps(conversion.exposure, conversion.exposure, conversion.exposure, 1.0f);
+    const auto quantize = conversion.sRGB
+        ? _mm_setr_ps(kSRGBTableSize - 1, kSRGBTableSize - 1, kSRGBTableSize - 1, 255.0f)
+        : _mm_set1_ps(255.0f);
+    const auto reinhard = conversion.toneMapping == ToneMapping::Reinhard;
+
+    // One pixel per register, alpha rides along with scale 1 and no tone mapping.
+    const auto convert = [&](const glm::vec4& pixel) -> __m128i {
+        auto v = _mm_mul_ps(_mm_loadu_ps(&pixel.x), exposure);
+        if (reinhard) {
+            const auto isInfinity = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_castps_si128(v), infinity));
+            const auto d = _mm_add_ps(one, _mm_mul_ps(v, colorMask));
+            const auto lo = _mm_div_pd(_mm_cvtps_pd(v), _mm_cvtps_pd(d));
+            const auto hi = _mm_div_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), _mm_cvtps_pd(_mm_movehl_ps(d, d)));
+            v = _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+            v = _mm_or_ps(_mm_and_ps(isInfinity, one), _mm_andnot_ps(isInfinity, v));
+        }
+        v = _mm_min_ps(_mm_max_ps(v, zero), one);
+        return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, quantize), half));
+    };
+
+    for (; i + 4 <= src.size(); i += 4) {
+        const auto p0 = convert(src[i + 0]);
+        const auto p1 = convert(src[i + 1]);
+        const auto p2 = convert(src[i + 2]);
+        const auto p3 = convert(src[i + 3]);
+
+        if (!conversion.sRGB) {
+            const auto packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]), packed);
+            continue;
+        }
+
+        alignas(16) glm::i32 indices[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(&indices[0]), p0);
+        _mm_store_si128(reinterpret_cast<__m128i*>(&indices[4]), p1);
+        _mm_store_si128(reinterpret_cast<__m128i*>(&indices[8]), p2);
+        _mm_store_si128(reinterpret_cast<__m128i*>(&indices[12]), p3);
+        for (size_t k = 0; k < 4; ++k) {
+            const auto* index = &indices[k * 4];
+            dst[i + k] = {table[index[0]], table[index[1]], table[index[2]], static_cast<glm::u8>(index[3])};
+        }
+    }
+#endif
+    for (; i < src.size(); ++i) {
+        dst[i] = ConvertPixel(src[i], conversion, table);
+    }
+}
+
+#if defined(BLAZE_TEXTURE_CONVERSION_SSE2) && !defined(__F16C__)
+// Float to half without F16C: rescales the exponent with a multiply and shifts the mantissa into
+// place, flushing values beyond the half range to infinity. NaN stays a quiet NaN, as with
+// F16C. Returns one half per 32-bit lane.
+static auto ConvertToHalf(__m128 f) -> __m128i {
+    const auto sign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(static_cast<glm::i32>(0x80000000u))));
+    const auto absf = _mm_xor_ps(f, sign);
+    const auto round = _mm_castsi128_ps(_mm_set1_epi32(~0xFFF));
+    const auto infinity = _mm_set1_epi32(255 << 23);
+
+    const auto isNormal = _mm_cmpgt_epi32(infinity, _mm_castps_si128(absf));
+    const auto isNaN = _mm_cmpgt_epi32(_mm_castps_si128(absf), infinity);
+    const auto scaled = _mm_mul_ps(_mm_and_ps(absf, round), _mm_castsi128_ps(_mm_set1_epi32(15 << 23)));
+    const auto clamped = _mm_min_ps(scaled, _mm_castsi128_ps(_mm_set1_epi32((31 << 23) - 0x1000)));
+    const auto biased = _mm_sub_epi32(_mm_castps_si128(clamped), _mm_castps_si128(round));
+    const auto normal = _mm_and_si128(_mm_srli_epi32(biased, 13), isNormal);
+    const auto special = _mm_or_si128(_mm_andnot_si128(isNormal, _mm_set1_epi32(0x7C00)), _mm_and_si128(isNaN, _mm_set1_epi32(0x0200)));
+
+    return _mm_or_si128(_mm_or_si128(normal, special), _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+#endif
+
+void ConvertPixels(std::span<const glm::vec4> src, std::span<glm::u16vec4> dst) {
+    assert(src.size() == dst.size());
+
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i < src.size(); ++i) {
+        const auto half = _mm_cvtps_ph(_mm_loadu_ps(&src[i].x), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[i]), half);
+    }
+#elif defined(BLAZE_TEXTURE_CONVERSION_SSE2)
+    // SSE2 has no unsigned 32 to 16 bit pack, so the halves are sign extended for packs_epi32.
+    const auto narrow = [](__m128i v) {
+        return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+    };
+    for (; i + 2 <= src.size(); i += 2) {
+        const auto h0 = ConvertToHalf(_mm_loadu_ps(&src[i + 0].x));
+        const auto h1 = ConvertToHalf(_mm_loadu_ps(&src[i + 1].x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[i]), _mm_packs_epi32(narrow(h0), narrow(h1)));
+    }
+#endif
+    for (; i < src.size(); ++i) {
+        const auto half = glm::packHalf4x16(src[i]);
+        std::memcpy(&dst[i], &half, sizeof(half));
+    }
+}
+
+// Calls fn(dst, a, b, c, d) with the four source indices of every destination texel from x0 on.
+template <typename Fn>
+static void ForEachQuad(glm::uvec2 extent, glm::u32 y, glm::u32 x0, Fn&& fn) {
+    const auto width = std::max(extent.x / 2, 1u);
+    const auto y0 = std::min(y * 2, extent.y - 1);
+    const auto y1 = std::min(y * 2 + 1, extent.y - 1);
+    for (auto x = x0; x < width; ++x) {
+        const auto sx0 = std::min(x * 2, extent.x - 1);
+        const auto sx1 = std::min(x * 2 + 1, extent.x - 1);
+        fn(
+            size_t(y) * width + x,
+            size_t(y0) * extent.x + sx0,
+            size_t(y0) * extent.x + sx1,
+            size_t(y1) * extent.x + sx0,
+            size_t(y1) * extent.x + sx1
+        );
+    }
+}
+
+void DownsamplePixels(std::span<const glm::u8vec4> src, glm::uvec2 extent, std::span<glm::u8vec4> dst) {
+    const auto next = GetMipExtent(extent, 1);
+    assert(src.size() == size_t(extent.x) * extent.y && dst.size() == size_t(next.x) * next.y);
+
+    for (glm::u32 y = 0; y < next.y; ++y) {
+        glm::u32 x = 0;
+#if defined(BLAZE_TEXTURE_CONVERSION_SSE2)
+        // Two destination texels per step from four source texels of both rows, summed in 16 bits.
+        if (extent.x > 1 && extent.y > 1) {
+            const auto zero = _mm_setzero_si128();
+            const auto bias = _mm_set1_epi16(2);
+            const auto* row0 = &src[size_t(y * 2) * extent.x];
+            const auto* row1 = &src[size_t(y * 2 + 1) * extent.x];
+            for (; x * 2 + 4 <= extent.x; x += 2) {
+                const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&row0[x * 2]));
+                const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&row1[x * 2]));
+                const auto lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                const auto hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                const auto s0 = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                const auto s1 = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+                const auto sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s0, s1), bias), 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[size_t(y) * next.x + x]), _mm_packus_epi16(sum, zero));
+            }
+        }
+#endif
+        ForEachQuad(extent, y, x, [&](size_t i, size_t a, size_t b, size_t c, size_t d) {
+            const auto sum = glm::uvec4(src[a]) + glm::uvec4(src[b]) + glm::uvec4(src[c]) + glm::uvec4(src[d]);
+            dst[i] = glm::u8vec4((sum + 2u) / 4u);
+        });
+    }
+}
+
+void DownsamplePixels(std::span<const glm::vec4> src, glm::uvec2 extent, std::span<glm::vec4> dst) {
+    const auto next = GetMipExtent(extent, 1);
+    assert(src.size() == size_t(extent.x) * extent.y && dst.size() == size_t(next.x) * next.y);
+
+    for (glm::u32 y = 0; y < next.y; ++y) {
+        ForEachQuad(extent, y, 0, [&](size_t i, size_t a, size_t b, size_t c, size_t d) {
+#if defined(BLAZE_TEXTURE_CONVERSION_SSE2)
+            const auto ab = _mm_add_ps(_mm_loadu_ps(&src[a].x), _mm_loadu_ps(&src[b].x));
+            const auto cd = _mm_add_ps(_mm_loadu_ps(&src[c].x), _mm_loadu_ps(&src[d].x));
+            _mm_storeu_ps(&dst[i].x, _mm_mul_ps(_mm_add_ps(ab, cd), _mm_set1_ps(0.25f)));
+#else
+            dst[i] = (src[a] + src[b] + src[c] + src[d]) * 0.25f;
+#endif
+        });
+    }
+}
+
+// Half levels are rare enough on the CPU path to go through glm's scalar packing.
+void DownsamplePixels(std::span<const glm::u16vec4> src, glm::uvec2 extent, std::span<glm::u16vec4> dst) {
+    const auto next = GetMipExtent(extent, 1);
+    assert(src.size() == size_t(extent.x) * extent.y && dst.size() == size_t(next.x) * next.y);
+
+    const auto unpack = [&](size_t i) {
+        auto half = glm::u64{};
+        std::memcpy(&half, &src[i], sizeof(half));
+        return glm::unpackHalf4x16(half);
+    };
+
+    for (glm::u32 y = 0; y < next.y; ++y) {
+        ForEachQuad(extent, y, 0, [&](size_t i, size_t a, size_t b, size_t c, size_t d) {
+            const auto half = glm::packHalf4x16((unpack(a) + unpack(b) + unpack(c) + unpack(d)) * 0.25f);
+            std::memcpy(&dst[i], &half, sizeof(half));
+        });
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <span>
+#include <glm/glm.hpp>
+
+#include "TextureData.hpp"
+
+enum class ToneMapping {
+    None,
+    Reinhard
+};
+
+// Applied to the color channels before quantization, alpha is only clamped.
+struct TextureConversion {
+    glm::f32 exposure = 1.0f;
+    ToneMapping toneMapping = ToneMapping::None;
+    bool sRGB = false;
+};
+
+// Bulk conversions over pixel runs, vectorized with SSE2 where available. Source and destination
+// must have the same number of pixels.
+void ConvertPixels(std::span<const glm::vec4> src, std::span<glm::u8vec4> dst, const TextureConversion& conversion = {});
+void ConvertPixels(std::span<const glm::vec4> src, std::span<glm::u16vec4> dst);
+
+// Converts the whole storage, tiles included, so both textures must share dimension and layout.
+inline void ConvertTextureData(const HDRTextureData& src, TextureData& dst, const TextureConversion& conversion = {}) {
+    assert(src.getDimension() == dst.getDimension() && src.getLayout() == dst.getLayout());
+    ConvertPixels(src.getPixels(), dst.getPixels(), conversion);
+}
+
+inline void ConvertTextureData(const HDRTextureData& src, HalfTextureData& dst) {
+    assert(src.getDimension() == dst.getDimension() && src.getLayout() == dst.getLayout());
+    ConvertPixels(src.getPixels(), dst.getPixels());
+}
+
+// Box filters one linear mip level into the next, whose extent is max(extent / 2, 1). A level
+// that is one texel wide or tall is filtered along the other axis only.
+void DownsamplePixels(std::span<const glm::u8vec4> src, glm::uvec2 extent, std::span<glm::u8vec4> dst);
+void DownsamplePixels(std::span<const glm::vec4> src, glm::uvec2 extent, std::span<glm::vec4> dst);
+void DownsamplePixels(std::span<const glm::u16vec4> src, glm::uvec2 extent, std::span<glm::u16vec4> dst);
+
+inline auto GetMipExtent(glm::uvec2 extent, glm::u32 level) -> glm::uvec2 {
+    return glm::max(extent >> level, glm::uvec2(1));
+}
@@ -2,14 +2,43 @@
 
 #include <span>
 #include <memory>
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include <concepts>
 #include <glm/glm.hpp>
 
-struct TextureData {
-    static auto Create(glm::u32 width, glm::u32 height) -> TextureData {
-        TextureData data;
+// Linear stores rows one after another. Tiled stores 4x4 pixel tiles in row-major tile order,
+// so an 8-bit tile is one 64 byte cache line and 2D neighbourhoods stay within a few lines.
+enum class TextureLayout {
+    Linear,
+    Tiled
+};
+
+struct TextureRegion {
+    glm::uvec2 offset{};
+    glm::uvec2 extent{};
+
+    [[nodiscard]] auto getArea() const -> size_t {
+        return static_cast<size_t>(extent.x) * extent.y;
+    }
+};
+
+// Pixel storage shared by the 8-bit and the HDR variants. Both use the same layouts, so a
+// conversion between them can run over the storage spans without reordering.
+template <typename Pixel>
+struct BasicTextureData {
+    static constexpr glm::u32 kTileSize = 4;
+    static constexpr glm::u32 kTileShift = 2;
+    static constexpr size_t kMaxDirtyRegions = 16;
+
+    static auto Create(glm::u32 width, glm::u32 height, TextureLayout layout = TextureLayout::Linear) -> BasicTextureData {
+        BasicTextureData data;
         data._width = width;
         data._height = height;
-        data._pixels = std::make_unique<glm::u8vec4[]>(static_cast<size_t>(width) * height);
+        data._layout = layout;
+        data._tilesX = (width + kTileSize - 1) >> kTileShift;
+        data._pixels = std::make_unique<Pixel[]>(data._getStorageSize());
         return data;
     }
 
@@ -17,29 +46,177 @@ struct TextureData {
         return {_width, _height};
     }
 
+    [[nodiscard]] auto getLayout() const -> TextureLayout {
+        return _layout;
+    }
+
+    // Pixels in storage order, which is only row-major for the linear layout.
+    [[nodiscard]] auto getPixels() const & -> std::span<const Pixel> {
+        return {_pixels.get(), _getStorageSize()};
+    }
 
-    [[nodiscard]] auto getPixels() const & -> std::span<const glm::u8vec4> {
-        return {_pixels.get(), static_cast<size_t>(_width) * _height};
+    [[nodiscard]] auto getPixels() & -> std::span<Pixel> {
+        return {_pixels.get(), _getStorageSize()};
     }
 
-    [[nodiscard]] auto getPixel(glm::u32 x, glm::u32 y) const -> glm::u8vec4 {
+    [[nodiscard]] auto getPixel(glm::u32 x, glm::u32 y) const -> Pixel {
         assert(x <= _width && y <= _height);
-        return _pixels[static_cast<size_t>(y) * _width + x];
+        return _pixels[_getIndex(x, y)];
     }
 
-    void setPixel(glm::u32 x, glm::u32 y, const glm::u8vec4& pixel) & {
+    void setPixel(glm::u32 x, glm::u32 y, const Pixel& pixel) & {
         assert(x <= _width && y <= _height);
-        _pixels[static_cast<size_t>(y) * _width + x] = pixel;
+        _pixels[_getIndex(x, y)] = pixel;
     }
 
-    void setPixel(glm::u32 x, glm::u32 y, const glm::vec4& pixel) & {
+    void setPixel(glm::u32 x, glm::u32 y, const glm::vec4& pixel) & requires std::same_as<Pixel, glm::u8vec4> {
         assert(x <= _width && y <= _height);
         const auto p = glm::clamp(pixel, 0.0f, 1.0f);
-        _pixels[static_cast<size_t>(y) * _width + x] = glm::u8vec4(p * 255.0f);
+        _pixels[_getIndex(x, y)] = glm::u8vec4(p * 255.0f);
+    }
+
+    // Visits every pixel in storage order, which is the cache friendly order for either layout.
+    template <typename Fn>
+    void forEachPixel(Fn&& fn) & {
+        if (_layout == TextureLayout::Linear) {
+            auto* pixel = _pixels.get();
+            for (glm::u32 y = 0; y < _height; ++y) {
+                for (glm::u32 x = 0; x < _width; ++x) {
+                    fn(x, y, *pixel++);
+                }
+            }
+            return;
+        }
+
+        for (glm::u32 ty = 0; ty < _height; ty += kTileSize) {
+            for (glm::u32 tx = 0; tx < _width; tx += kTileSize) {
+                auto* tile = &_pixels[_getIndex(tx, ty)];
+                for (glm::u32 y = ty; y < glm::min(ty + kTileSize, _height); ++y) {
+                    for (glm::u32 x = tx; x < glm::min(tx + kTileSize, _width); ++x) {
+                        fn(x, y, tile[((y - ty) << kTileShift) + (x - tx)]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Writes the pixels row-major into dst, which must hold width * height pixels.
+    void copyPixels(std::span<Pixel> dst) const {
+        copyPixels(dst, TextureRegion{.extent = {_width, _height}});
+    }
+
+    // Writes the region row-major and tightly packed into dst. Tiled rows are copied one tile
+    // row at a time, and full-width linear regions are a single memcpy.
+    void copyPixels(std::span<Pixel> dst, const TextureRegion& region) const {
+        assert(dst.size() >= region.getArea());
+        assert(region.offset.x + region.extent.x <= _width && region.offset.y + region.extent.y <= _height);
+
+        if (_layout == TextureLayout::Linear) {
+            const auto* src = &_pixels[_getIndex(region.offset.x, region.offset.y)];
+            if (region.extent.x == _width) {
+                std::memcpy(dst.data(), src, region.getArea() * sizeof(Pixel));
+                return;
+            }
+            for (glm::u32 y = 0; y < region.extent.y; ++y) {
+                std::memcpy(&dst[static_cast<size_t>(y) * region.extent.x], src + static_cast<size_t>(y) * _width, region.extent.x * sizeof(Pixel));
+            }
+            return;
+        }
+
+        auto* out = dst.data();
+        for (glm::u32 y = region.offset.y; y < region.offset.y + region.extent.y; ++y) {
+            for (glm::u32 x = region.offset.x; x < region.offset.x + region.extent.x;) {
+                const auto count = glm::min(kTileSize - (x & (kTileSize - 1)), region.offset.x + region.extent.x - x);
+                std::memcpy(out, &_pixels[_getIndex(x, y)], count * sizeof(Pixel));
+                out += count;
+                x += count;
+            }
+        }
+    }
+
+    // Records a region for the next partial upload. A region is merged with the ones it overlaps
+    // or touches when their bounding box adds no pixels, and past kMaxDirtyRegions everything
+    // collapses into one bounding box to bound the number of copies.
+    void markDirty(const TextureRegion& region) & {
+        const auto min = glm::min(region.offset, glm::uvec2(_width, _height));
+        const auto max = glm::min(region.offset + region.extent, glm::uvec2(_width, _height));
+        if (min.x >= max.x || min.y >= max.y) {
+            return;
+        }
+
+        auto merged = TextureRegion{.offset = min, .extent = max - min};
+        for (size_t i = 0; i < _dirtyRegions.size();) {
+            const auto bounds = _getBounds(_dirtyRegions[i], merged);
+            if (bounds.getArea() > _dirtyRegions[i].getArea() + merged.getArea() - _getOverlapArea(_dirtyRegions[i], merged)) {
+                i += 1;
+                continue;
+            }
+            merged = bounds;
+            _dirtyRegions.erase(_dirtyRegions.begin() + static_cast<std::ptrdiff_t>(i));
+            i = 0;
+        }
+        _dirtyRegions.emplace_back(merged);
+
+        if (_dirtyRegions.size() > kMaxDirtyRegions) {
+            for (const auto& dirty : _dirtyRegions) {
+                merged = _getBounds(merged, dirty);
+            }
+            _dirtyRegions = {merged};
+        }
+    }
+
+    void markDirty() & {
+        _dirtyRegions = {TextureRegion{.extent = {_width, _height}}};
+    }
+
+    [[nodiscard]] auto getDirtyRegions() const -> std::span<const TextureRegion> {
+        return _dirtyRegions;
+    }
+
+    void clearDirtyRegions() & {
+        _dirtyRegions.clear();
     }
 
 private:
+    static auto _getBounds(const TextureRegion& a, const TextureRegion& b) -> TextureRegion {
+        const auto min = glm::min(a.offset, b.offset);
+        const auto max = glm::max(a.offset + a.extent, b.offset + b.extent);
+        return {.offset = min, .extent = max - min};
+    }
+
+    static auto _getOverlapArea(const TextureRegion& a, const TextureRegion& b) -> size_t {
+        const auto min = glm::max(a.offset, b.offset);
+        const auto max = glm::min(a.offset + a.extent, b.offset + b.extent);
+        if (min.x >= max.x || min.y >= max.y) {
+            return 0;
+        }
+        return static_cast<size_t>(max.x - min.x) * (max.y - min.y);
+    }
+
+    [[nodiscard]] auto _getIndex(glm::u32 x, glm::u32 y) const -> size_t {
+        if (_layout == TextureLayout::Linear) {
+            return static_cast<size_t>(y) * _width + x;
+        }
+        const auto tile = static_cast<size_t>(y >> kTileShift) * _tilesX + (x >> kTileShift);
+        return (tile << (2 * kTileShift)) + ((y & (kTileSize - 1)) << kTileShift) + (x & (kTileSize - 1));
+    }
+
+    [[nodiscard]] auto _getStorageSize() const -> size_t {
+        if (_layout == TextureLayout::Linear) {
+            return static_cast<size_t>(_width) * _height;
+        }
+        const auto tilesY = (_height + kTileSize - 1) >> kTileShift;
+        return static_cast<size_t>(_tilesX) * tilesY * kTileSize * kTileSize;
+    }
+
     glm::u32 _width = 0;
     glm::u32 _height = 0;
-    std::unique_ptr<glm::u8vec4[]> _pixels;
+    glm::u32 _tilesX = 0;
+    TextureLayout _layout = TextureLayout::Linear;
+    std::unique_ptr<Pixel[]> _pixels;
+    std::vector<TextureRegion> _dirtyRegions;
 };
+
+using TextureData = BasicTextureData<glm::u8vec4>;
+using HDRTextureData = BasicTextureData<glm::vec4>;
+using HalfTextureData = BasicTextureData<glm::u16vec4>;
@@ -0,0 +1,212 @@
+#include "TextureStreamer.hpp"
+#include "Material.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <VulkanGfxDevice.hpp>
+
+extern auto GetGfxDevice() -> VulkanGfxDevice&;
+
+// The finest level whose texels are no smaller than the pixels they cover.
+static auto GetLevelForScreenSize(const KTX2Header& header, glm::f32 screenSize, glm::u32 coarsest) -> glm::u32 {
+    const auto size = static_cast<glm::f32>(std::max(header.pixelWidth, header.pixelHeight));
+    const auto level = std::floor(std::log2(size / screenSize));
+    return level <= 0.0f ? 0 : std::min(static_cast<glm::u32>(level), coarsest);
+}
+
+TextureStreamer::TextureStreamer(const TextureStreamerSettings& settings) : _settings(settings) {}
+
+auto TextureStreamer::add(const std::string& filename) -> tl::optional<StreamedTextureId> {
+    auto reader = KTX2Reader::open(filename);
+    if (!reader) {
+        return tl::nullopt;
+    }
+
+    // Without a stored chain there is nothing to stream, the texture is loaded whole.
+    const auto& header = reader->getHeader();
+    const auto levelCount = static_cast<glm::u32>(reader->getLevels().size());
+
+    auto residentLevel = glm::u32{};
+    if (header.levelCount > 1) {
+        residentLevel = levelCount - 1;
+        for (glm::u32 level = 0; level < levelCount; ++level) {
+            if (std::max(header.pixelWidth >> level, header.pixelHeight >> level) <= _settings.residentSize) {
+                residentLevel = level;
+                break;
+            }
+        }
+    }
+
+    auto texture = reader->createTexture(residentLevel);
+
+    const auto id = static_cast<StreamedTextureId>(_entries.size());
+    auto& entry = _entries.emplace_back(Entry{
+        .reader = std::move(*reader),
+        .texture = std::move(texture),
+        .baseLevel = residentLevel,
+        .residentLevel = residentLevel,
+        .desiredLevel = residentLevel,
+        .lastUsed = _updates
+    });
+    _residentBytes += _getBytes(entry, residentLevel);
+    return id;
+}
+
+void TextureStreamer::bind(StreamedTextureId id, Material& material, glm::u32 index) {
+    auto& entry = _entries[id];
+    entry.bindings.emplace_back(Binding{
+        .material = &material,
+        .index = index
+    });
+    material.SetTexture(index, entry.texture);
+}
+
+void TextureStreamer::reportUsage(StreamedTextureId id, glm::f32 screenSize) {
+    auto& entry = _entries[id];
+    entry.screenSize = std::max(entry.screenSize, screenSize);
+}
+
+void TextureStreamer::update() {
+    ++_updates;
+    _completeLoads();
+
+    for (auto& entry : _entries) {
+        if (entry.screenSize > 0.0f) {
+            entry.desiredLevel = GetLevelForScreenSize(entry.reader.getHeader(), entry.screenSize, entry.residentLevel);
+            entry.lastUsed = _updates;
+            entry.screenSize = 0.0f;
+        } else if (_updates - entry.lastUsed > _settings.evictAfterUpdates) {
+            entry.desiredLevel = entry.residentLevel;
+        }
+    }
+
+    _updateBudget();
+
+    auto started = glm::u32{};
+    _evict(started);
+    _streamIn(started);
+}
+
+auto TextureStreamer::_getBytes(const Entry& entry, glm::u32 baseLevel) const -> glm::u64 {
+    auto bytes = glm::u64{};
+    for (const auto& level : entry.reader.getLevels().subspan(baseLevel)) {
+        bytes += level.byteLength;
+    }
+    return bytes;
+}
+
+// Our own textures count against the budget VMA reports, so they are added back before
+// taking out the rest of the process.
+void TextureStreamer::_updateBudget() {
+    const auto budget = GetGfxDevice().GetDeviceLocalBudget();
+    const auto other = budget.usage - std::min(budget.usage, _residentBytes);
+    const auto available = budget.budget - std::min(budget.budget, other);
+    const auto limit = _settings.budget != 0
+        ? _settings.budget
+        : static_cast<glm::u64>(static_cast<glm::f64>(budget.budget) * _settings.budgetFraction);
+
+    _budget = std::min(limit, available);
+}
+
+// Levels finer than wanted go first, then the least recently used, one level at a time.
+void TextureStreamer::_evict(glm::u32& started) {
+    while (_residentBytes > _budget && started < _settings.maxSwapsPerUpdate) {
+        auto victim = tl::optional<StreamedTextureId>{};
+        for (StreamedTextureId id = 0; id < _entries.size(); ++id) {
+            const auto& entry = _entries[id];
+            if (entry.baseLevel >= entry.residentLevel || entry.load.valid()) {
+                continue;
+            }
+            if (!victim) {
+                victim = id;
+                continue;
+            }
+            const auto& current = _entries[*victim];
+            const auto unneeded = entry.baseLevel < entry.desiredLevel;
+            const auto currentUnneeded = current.baseLevel < current.desiredLevel;
+            if (unneeded != currentUnneeded ? unneeded : entry.lastUsed < current.lastUsed) {
+                victim = id;
+            }
+        }
+        if (!victim) {
+            break;
+        }
+
+        const auto& entry = _entries[*victim];
+        _load(*victim, std::max(entry.baseLevel + 1, entry.desiredLevel));
+        ++started;
+    }
+}
+
+// The textures furthest from their desired level go first, stopping short of it where the
+// budget does not allow the full chain.
+void TextureStreamer::_streamIn(glm::u32& started) {
+    auto candidates = std::vector<StreamedTextureId>{};
+    for (StreamedTextureId id = 0; id < _entries.size(); ++id) {
+        const auto& entry = _entries[id];
+        if (entry.desiredLevel < entry.baseLevel && !entry.load.valid()) {
+            candidates.emplace_back(id);
+        }
+    }
+    std::ranges::sort(candidates, [this](StreamedTextureId a, StreamedTextureId b) {
+        const auto& lhs = _entries[a];
+        const auto& rhs = _entries[b];
+        return lhs.baseLevel - lhs.desiredLevel > rhs.baseLevel - rhs.desiredLevel;
+    });
+
+    for (const auto id : candidates) {
+        if (started >= _settings.maxSwapsPerUpdate) {
+            break;
+        }
+
+        const auto& entry = _entries[id];
+        const auto current = _getBytes(entry, entry.baseLevel);
+
+        auto level = entry.desiredLevel;
+        while (level < entry.baseLevel && _residentBytes - current + _getBytes(entry, level) > _budget) {
+            ++level;
+        }
+        if (level < entry.baseLevel) {
+            _load(id, level);
+            ++started;
+        }
+    }
+}
+
+// Levels are read from the file again rather than copied from the old image, the coarse ones
+// are a fraction of the finest and are likely still in the page cache. The bytes count as
+// resident from the start, so the budget holds while the read is in flight.
+void TextureStreamer::_load(StreamedTextureId id, glm::u32 baseLevel) {
+    auto& entry = _entries[id];
+
+    _residentBytes = _residentBytes - _getBytes(entry, entry.baseLevel) + _getBytes(entry, baseLevel);
+    entry.loadLevel = baseLevel;
+    entry.load = std::async(std::launch::async, [&reader = entry.reader, baseLevel] {
+        return reader.readLevels(baseLevel);
+    });
+}
+
+// The materials move to the new texture before the old one is released, which leaves the
+// image alive until the frames that drew it are done.
+void TextureStreamer::_completeLoads() {
+    for (auto& entry : _entries) {
+        if (!entry.load.valid() || entry.load.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            continue;
+        }
+
+        const auto levels = entry.load.get();
+        if (!levels) {
+            _residentBytes = _residentBytes - _getBytes(entry, entry.loadLevel) + _getBytes(entry, entry.baseLevel);
+            continue;
+        }
+
+        auto texture = entry.reader.createTexture(entry.loadLevel, *levels);
+        texture.setSamplerDescriptor(entry.texture.samplerDescriptor());
+        for (const auto& binding : entry.bindings) {
+            binding.material->SetTexture(binding.index, texture);
+        }
+        entry.texture = std::move(texture);
+        entry.baseLevel = entry.loadLevel;
+    }
+}
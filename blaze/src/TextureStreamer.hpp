@@ -0,0 +1,93 @@
+#pragma once
+
+#include "KTX2.hpp"
+#include "Texture.hpp"
+
+#include <deque>
+#include <future>
+#include <string>
+#include <vector>
+#include <tl/optional.hpp>
+
+struct Material;
+
+struct TextureStreamerSettings {
+    // Device-local bytes the streamed textures may occupy, 0 takes budgetFraction of the VMA
+    // budget. Either way the limit shrinks to what the rest of the process leaves free.
+    glm::u64 budget = 0;
+    glm::f32 budgetFraction = 0.5f;
+    // Levels no larger than this are loaded up front and never evicted.
+    glm::u32 residentSize = 64;
+    // Textures that see no usage for this many updates fall back to the resident levels.
+    glm::u32 evictAfterUpdates = 120;
+    // Stream-ins and evictions recreate a texture each, at most this many are started per update.
+    glm::u32 maxSwapsPerUpdate = 2;
+};
+
+using StreamedTextureId = glm::u32;
+
+// Streams the levels of KTX2 textures by how large they are drawn on screen. A texture starts
+// with its coarsest levels only, and is recreated with a finer base level once draws report it
+// large enough, or a coarser one to stay within budget.
+//
+// Levels are read on a worker thread, one load per texture at a time, and the new texture is
+// swapped in by the first update after the read. The old one is released like any other
+// texture, once the frames that drew it are done, and materials see the new one from their
+// next frame on.
+struct TextureStreamer {
+    explicit TextureStreamer(const TextureStreamerSettings& settings = {});
+
+    auto add(const std::string& filename) -> tl::optional<StreamedTextureId>;
+    // Rebinds the material on every swap, it must outlive the streamer.
+    void bind(StreamedTextureId id, Material& material, glm::u32 index);
+    // The size in pixels of the larger side of the texture as drawn, the largest report since
+    // the last update wins.
+    void reportUsage(StreamedTextureId id, glm::f32 screenSize);
+    // Once per frame, before drawing.
+    void update();
+
+    [[nodiscard]] auto getTexture(StreamedTextureId id) const -> const Texture2D& {
+        return _entries[id].texture;
+    }
+    [[nodiscard]] auto getResidentBytes() const -> glm::u64 {
+        return _residentBytes;
+    }
+    [[nodiscard]] auto getBudget() const -> glm::u64 {
+        return _budget;
+    }
+
+private:
+    struct Binding {
+        Material* material;
+        glm::u32 index;
+    };
+
+    struct Entry {
+        KTX2Reader reader;
+        Texture2D texture;
+        std::vector<Binding> bindings;
+        // First level of the file in the texture, and the coarsest one it may fall back to.
+        glm::u32 baseLevel;
+        glm::u32 residentLevel;
+        glm::u32 desiredLevel;
+        glm::f32 screenSize = 0.0f;
+        glm::u64 lastUsed = 0;
+        // Levels from loadLevel on, read by a worker while valid. The reader is not touched
+        // by anything else until then, and the entry must not move.
+        std::future<tl::optional<std::vector<std::byte>>> load;
+        glm::u32 loadLevel = 0;
+    };
+
+    auto _getBytes(const Entry& entry, glm::u32 baseLevel) const -> glm::u64;
+    void _updateBudget();
+    void _completeLoads();
+    void _evict(glm::u32& started);
+    void _streamIn(glm::u32& started);
+    void _load(StreamedTextureId id, glm::u32 baseLevel);
+
+    TextureStreamerSettings _settings;
+    std::deque<Entry> _entries;
+    glm::u64 _residentBytes = 0;
+    glm::u64 _budget = 0;
+    glm::u64 _updates = 0;
+};
@@ -2,17 +2,21 @@
 #include "Material.hpp"
 #include "Texture.hpp"
 #include "Blaze.hpp"
-#include "Mesh.hpp"
 #include "Input.hpp"
+#include "Graphics.hpp"
 #include "VulkanMaterial.hpp"
 
+#include <cstring>
 #include <imgui.h>
 #include <glm/glm.hpp>
 #include <imgui_internal.h>
 #include <vulkan/vulkan.hpp>
-#include <VulkanGraphicsBuffer.hpp>
+#include <VulkanGfxDevice.hpp>
+#include <VulkanFrameAllocator.hpp>
 
-UserInterface::UserInterface(size_t frameCount) {
+extern auto GetGfxDevice() -> VulkanGfxDevice&;
+
+UserInterface::UserInterface() {
     IMGUI_CHECKVERSION();
     _ctx = ImGui::CreateContext();
 
@@ -68,10 +72,6 @@ UserInterface::UserInterface(size_t frameCount) {
 //    _mouseCursors[ImGuiMouseCursor_NotAllowed] = glfwCreateStandardCursor(GLFW_ARROW_CURSOR);
 //#endif
 
-    _frameIndex = 0;
-    _frameCount = frameCount;
-    _frames.resize(_frameCount);
-
     ImGui::StyleColorsDark(&_ctx->Style);
 
     _ctx->Style.WindowRounding = 0.0f;
@@ -93,8 +93,6 @@ UserInterface::~UserInterface() {
     //        glfwDestroyCursor(_mouseCursors[cursor_n]);
     //        _mouseCursors[cursor_n] = NULL;
     //    }
-
-    _frames.clear();
 }
 
 void UserInterface::SetDisplaySize(const glm::ivec2& size) {
@@ -130,6 +128,43 @@ void UserInterface::SetKeyPressed(int button, bool flag) {
     _ctx->IO.KeysDown[button] = flag;
 }
 
+void UserInterface::DrawMemoryStatistics() {
+    static constexpr auto MiB = 1024.0f * 1024.0f;
+
+    const auto statistics = Graphics::GetMemoryStatistics();
+
+    ImGui::Begin("Memory");
+    if (ImGui::BeginTable("Heaps", 5)) {
+        ImGui::TableSetupColumn("Heap");
+        ImGui::TableSetupColumn("Usage / Budget");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableSetupColumn("Blocks");
+        ImGui::TableSetupColumn("Fragmentation");
+        ImGui::TableHeadersRow();
+        for (size_t heap = 0; heap < statistics.heaps.size(); ++heap) {
+            const auto& stats = statistics.heaps[heap];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu%s", heap, stats.deviceLocal ? " (device)" : "");
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f / %.1f MiB", static_cast<float>(stats.usage) / MiB, static_cast<float>(stats.budget) / MiB);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.allocationCount);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", stats.blockCount);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f%%", stats.fragmentation() * 100.0f);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Separator();
+    for (size_t category = 0; category < statistics.categories.size(); ++category) {
+        const auto& stats = statistics.categories[category];
+        ImGui::Text("%s: %u, %.1f MiB", kMemoryCategoryNames[category], stats.count, static_cast<float>(stats.bytes) / MiB);
+    }
+    ImGui::End();
+}
+
 void UserInterface::Draw(CommandBuffer cmd) {
     const auto viewport = _ctx->Viewports[0];
     if (!viewport->DrawDataP.Valid) {
@@ -150,24 +185,26 @@ void UserInterface::Draw(CommandBuffer cmd) {
         return;
     }
 
-    auto& frame = _frames[_frameIndex];
-
+    // The geometry only lives for this frame, it goes into the frame allocator.
+    auto vertices = VulkanFrameAllocation{};
+    auto indices = VulkanFrameAllocation{};
     if (drawData->TotalVtxCount > 0) {
-        frame.setVertexBufferParams(drawData->TotalVtxCount, sizeof(ImDrawVert));
-        frame.setIndexBufferParams(drawData->TotalIdxCount, sizeof(ImDrawIdx));
+        auto& allocator = GetGfxDevice().getFrameAllocator();
+        vertices = allocator.allocate(drawData->TotalVtxCount * sizeof(ImDrawVert), alignof(ImDrawVert));
+        indices = allocator.allocate(drawData->TotalIdxCount * sizeof(ImDrawIdx), sizeof(ImDrawIdx));
 
-        auto vtx_dst_offset = 0;
-        auto idx_dst_offset = 0;
+        auto vtx_dst = reinterpret_cast<ImDrawVert*>(vertices.data);
+        auto idx_dst = reinterpret_cast<ImDrawIdx*>(indices.data);
         for (int n = 0; n < drawData->CmdListsCount; n++) {
             auto cmd_list = drawData->CmdLists[n];
-            frame.setVertexBufferData(cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), vtx_dst_offset);
-            frame.setIndexBufferData(cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), idx_dst_offset);
-            vtx_dst_offset += static_cast<int>(cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-            idx_dst_offset += static_cast<int>(cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            std::memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+            std::memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            vtx_dst += cmd_list->VtxBuffer.Size;
+            idx_dst += cmd_list->IdxBuffer.Size;
         }
     }
 
-    _setupRenderState(drawData, cmd, &frame, fb_width, fb_height);
+    _setupRenderState(drawData, cmd, vertices, indices, fb_width, fb_height);
 
     int global_vtx_offset = 0;
     int global_idx_offset = 0;
@@ -177,7 +214,7 @@ void UserInterface::Draw(CommandBuffer cmd) {
             auto pcmd = &cmd_list->CmdBuffer[cmd_i];
             if (pcmd->UserCallback != nullptr) {
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState) {
-                    _setupRenderState(drawData, cmd, &frame, fb_width, fb_height);
+                    _setupRenderState(drawData, cmd, vertices, indices, fb_width, fb_height);
                 } else {
                     pcmd->UserCallback(cmd_list, pcmd);
                 }
@@ -212,8 +249,6 @@ void UserInterface::Draw(CommandBuffer cmd) {
         global_idx_offset += cmd_list->IdxBuffer.Size;
         global_vtx_offset += cmd_list->VtxBuffer.Size;
     }
-
-    _frameIndex = (_frameIndex + 1) % _frameCount;
 }
 
 void UserInterface::_createFontsTexture() {
@@ -226,7 +261,7 @@ void UserInterface::_createFontsTexture() {
     _material.SetTexture(0, _fontTexture);
 }
 
-void UserInterface::_setupRenderState(ImDrawData* draw_data, CommandBuffer cmd, Mesh* rb, int fb_width, int fb_height) {
+void UserInterface::_setupRenderState(ImDrawData* draw_data, CommandBuffer cmd, const VulkanFrameAllocation& vertices, const VulkanFrameAllocation& indices, int fb_width, int fb_height) {
     auto vk_material = static_cast<VulkanMaterial*>(_material.GetNativeHandlePtr());
 
     (*cmd).bindPipeline(vk::PipelineBindPoint::eGraphics, vk_material->pipeline);
@@ -234,16 +269,13 @@ void UserInterface::_setupRenderState(ImDrawData* draw_data, CommandBuffer cmd,
         vk::PipelineBindPoint::eGraphics,
         vk_material->pipelineLayout,
         0,
-        vk_material->descriptorSets,
+        vk_material->descriptorSet,
         vk_material->dynamicOffsets
     );
 
     if (draw_data->TotalVtxCount > 0) {
-        auto vtx_ptr = static_cast<VulkanGraphicsBuffer*>(rb->getNativeVertexBufferPtr());
-        auto idx_ptr = static_cast<VulkanGraphicsBuffer*>(rb->getNativeIndexBufferPtr());
-
-        (*cmd).bindVertexBuffers(0, vtx_ptr->buffer, vk::DeviceSize{0});
-        (*cmd).bindIndexBuffer(idx_ptr->buffer, 0, vk::IndexType::eUint16);
+        (*cmd).bindVertexBuffers(0, vertices.buffer, vertices.offset);
+        (*cmd).bindIndexBuffer(indices.buffer, indices.offset, vk::IndexType::eUint16);
     }
 
     (*cmd).setViewport(0, vk::Viewport{0, 0, float(fb_width), float(fb_height), 0, 1});
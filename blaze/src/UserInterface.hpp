@@ -4,15 +4,15 @@
 #include <glm/glm.hpp>
 #include <glm/vec2.hpp>
 
-#include "Mesh.hpp"
 #include "Texture.hpp"
 #include "Material.hpp"
 #include "CommandBuffer.hpp"
 
 struct ImDrawData;
 struct ImGuiContext;
+struct VulkanFrameAllocation;
 struct UserInterface {
-    explicit UserInterface(size_t frameCount);
+    UserInterface();
     ~UserInterface();
 
     void SetDeltaTime(float delta);
@@ -23,6 +23,8 @@ struct UserInterface {
     void SetKeyPressed(int button, bool flag);
 
     void Draw(CommandBuffer cmd);
+    // A window with the heaps and what the engine allocated, called between NewFrame and Render.
+    void DrawMemoryStatistics();
 
     void SetCurrentContext();
     auto WantCaptureMouse() -> bool;
@@ -31,12 +33,9 @@ struct UserInterface {
 
 private:
     void _createFontsTexture();
-    void _setupRenderState(ImDrawData* draw_data, CommandBuffer cmd, Mesh* rb, int fb_width, int fb_height);
+    void _setupRenderState(ImDrawData* draw_data, CommandBuffer cmd, const VulkanFrameAllocation& vertices, const VulkanFrameAllocation& indices, int fb_width, int fb_height);
 
     ImGuiContext* _ctx;
     Material _material{};
     Texture2D _fontTexture;
-    uint32_t _frameIndex;
-    uint32_t _frameCount;
-    std::vector<Mesh> _frames;
 };
@@ -0,0 +1,229 @@
+// Headless benchmark for the software raymarcher. Renders the sandbox scene into a TextureData
+// without a window or a Vulkan device and prints the results as JSON.
+//
+// usage: bench_raymarch [--frames N] [--warmup N] [--resolutions WxH,...] [--threads N,...]
+//                       [--reprojection 0,1] [--cone-block N,...] [--animate all,light,none]
+//
+// --animate picks what changes between frames: the scene and the light as in the sandbox, only
+// the light, or nothing. Reprojection only reuses colors for what did not change.
+
+#include "Raymarcher.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+
+static auto GetSimdName() -> const char* {
+#if defined(__AVX512F__)
+    return "avx512";
+#elif defined(__AVX2__)
+    return "avx2";
+#elif defined(__AVX__)
+    return "avx";
+#elif defined(__SSE4_1__)
+    return "sse4.1";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "sse2";
+#elif defined(__ARM_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+template <typename T, typename Parse>
+static auto ParseList(std::string_view text, Parse&& parse) -> std::vector<T> {
+    auto values = std::vector<T>{};
+    while (!text.empty()) {
+        const auto end = std::min(text.find(','), text.size());
+        values.emplace_back(parse(std::string(text.substr(0, end))));
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+    return values;
+}
+
+static auto ParseU32(const std::string& text) -> glm::u32 {
+    return static_cast<glm::u32>(std::strtoul(text.c_str(), nullptr, 10));
+}
+
+static auto ParseExtent(const std::string& text) -> glm::uvec2 {
+    const auto x = text.find('x');
+    if (x == std::string::npos) {
+        return glm::uvec2(0);
+    }
+    return {ParseU32(text.substr(0, x)), ParseU32(text.substr(x + 1))};
+}
+
+static auto GetPercentile(std::vector<double> samples, double percentile) -> double {
+    const auto n = static_cast<size_t>(percentile * static_cast<double>(samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(n), samples.end());
+    return samples[n];
+}
+
+enum class Animation {
+    All,
+    Light,
+    None
+};
+
+static auto ParseAnimation(const std::string& text) -> Animation {
+    if (text == "light") {
+        return Animation::Light;
+    }
+    if (text == "none") {
+        return Animation::None;
+    }
+    return Animation::All;
+}
+
+static auto GetAnimationName(Animation animation) -> const char* {
+    switch (animation) {
+        case Animation::All:
+            return "all";
+        case Animation::Light:
+            return "light";
+        case Animation::None:
+            return "none";
+    }
+    return "all";
+}
+
+struct Config {
+    glm::uvec2 extent;
+    glm::u32 threads;
+    bool reprojection;
+    glm::u32 coneBlockSize;
+    Animation animation;
+};
+
+// Drives the raymarcher exactly like Game::Update does, but with a fixed time step so that
+// every run renders the same frames.
+static void Run(const Config& config, glm::u32 warmup, glm::u32 frames, bool first) {
+    auto target = TextureData::Create(config.extent.x, config.extent.y);
+
+    auto raymarcher = Raymarcher{};
+    raymarcher.resolution = glm::vec2(config.extent);
+    raymarcher.cameraPosition = glm::vec3(5, 5, 5);
+    raymarcher.cameraRotation = camera(raymarcher.cameraPosition, glm::vec3(0, 0, 0));
+    raymarcher.multithreading = config.threads != 1;
+    raymarcher.threadCount = config.threads;
+    raymarcher.reprojection = config.reprojection;
+    raymarcher.coneBlockSize = config.coneBlockSize;
+
+    auto times = std::vector<double>{};
+    auto rays = glm::u64{};
+    auto iterations = glm::u64{};
+
+    for (glm::u32 frame = 0; frame < warmup + frames; ++frame) {
+        const auto time = static_cast<glm::f32>(frame + 1) / 60.0f;
+        if (config.animation == Animation::All) {
+            raymarcher.time = time;
+        }
+        const auto lightTime = config.animation == Animation::None ? 0.0f : time;
+        raymarcher.lightPosition = glm::vec3(
+            glm::sin(glm::radians(180.0f) * lightTime) * 2.0f,
+            0.5f,
+            glm::cos(glm::radians(180.0f) * lightTime) * 2.0f
+        );
+
+        const auto start = std::chrono::steady_clock::now();
+        raymarcher.render(target);
+        const auto end = std::chrono::steady_clock::now();
+
+        if (frame < warmup) {
+            continue;
+        }
+        const auto statistics = raymarcher.getStatistics();
+        rays += statistics.rays;
+        iterations += statistics.iterations;
+        times.emplace_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    auto total = 0.0;
+    for (const auto time : times) {
+        total += time;
+    }
+
+    const auto pixels = static_cast<double>(config.extent.x) * config.extent.y * frames;
+    std::printf(
+        "%s    {\"width\": %u, \"height\": %u, \"threads\": %u, \"reprojection\": %s, \"cone_block\": %u, \"animate\": \"%s\", "
+        "\"mrays_per_s\": %.3f, \"ns_per_pixel\": %.3f, \"avg_iterations\": %.3f, \"marched_fraction\": %.4f, "
+        "\"frame_ms_avg\": %.3f, \"frame_ms_p50\": %.3f, \"frame_ms_p99\": %.3f}",
+        first ? "" : ",\n",
+        config.extent.x,
+        config.extent.y,
+        config.threads,
+        config.reprojection ? "true" : "false",
+        config.coneBlockSize,
+        GetAnimationName(config.animation),
+        pixels / (total * 1e3),
+        total * 1e6 / pixels,
+        rays != 0 ? static_cast<double>(iterations) / static_cast<double>(rays) : 0.0,
+        static_cast<double>(rays) / pixels,
+        total / frames,
+        GetPercentile(times, 0.5),
+        GetPercentile(times, 0.99)
+    );
+    std::fflush(stdout);
+}
+
+auto main(int argc, char** argv) -> int {
+    auto frames = glm::u32{60};
+    auto warmup = glm::u32{5};
+    auto extents = std::vector<glm::uvec2>{{320, 240}, {800, 600}, {1920, 1080}};
+    auto threads = std::vector<glm::u32>{1, std::max(std::thread::hardware_concurrency(), 1u)};
+    auto reprojection = std::vector<glm::u32>{0, 1};
+    auto coneBlockSizes = std::vector<glm::u32>{8};
+    auto animations = std::vector<Animation>{Animation::All};
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const auto name = std::string_view(argv[i]);
+        const auto value = std::string_view(argv[i + 1]);
+
+        if (name == "--frames") {
+            frames = std::max(ParseU32(std::string(value)), 1u);
+        } else if (name == "--warmup") {
+            warmup = ParseU32(std::string(value));
+        } else if (name == "--resolutions") {
+            extents = ParseList<glm::uvec2>(value, ParseExtent);
+        } else if (name == "--threads") {
+            threads = ParseList<glm::u32>(value, ParseU32);
+        } else if (name == "--reprojection") {
+            reprojection = ParseList<glm::u32>(value, ParseU32);
+        } else if (name == "--cone-block") {
+            coneBlockSizes = ParseList<glm::u32>(value, ParseU32);
+        } else if (name == "--animate") {
+            animations = ParseList<Animation>(value, ParseAnimation);
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::printf("{\n  \"simd\": \"%s\",\n  \"hardware_threads\": %u,\n  \"frames\": %u,\n  \"results\": [\n", GetSimdName(), std::thread::hardware_concurrency(), frames);
+
+    auto first = true;
+    for (const auto& extent : extents) {
+        if (extent.x == 0 || extent.y == 0) {
+            continue;
+        }
+        for (const auto count : threads) {
+            for (const auto enabled : reprojection) {
+                for (const auto coneBlockSize : coneBlockSizes) {
+                    for (const auto animation : animations) {
+                        Run(Config{extent, count, enabled != 0, coneBlockSize, animation}, warmup, frames, first);
+                        first = false;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("\n  ]\n}\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+// Headless benchmark for the TextureData layouts. Measures filling, a 3x3 box blur, the HDR
+// conversions, the de-tiling copy into the linear staging layout and the block encoders on
+// every core, and prints JSON.
+//
+// usage: bench_texture_layout [--iterations N] [--resolutions WxH,...]
+
+#include <TextureData.hpp>
+#include <TextureConversion.hpp>
+#include <TextureCompression.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <string_view>
+
+static auto ParseU32(const std::string& text) -> glm::u32 {
+    return static_cast<glm::u32>(std::strtoul(text.c_str(), nullptr, 10));
+}
+
+static auto ParseExtents(std::string_view text) -> std::vector<glm::uvec2> {
+    auto extents = std::vector<glm::uvec2>{};
+    while (!text.empty()) {
+        const auto end = std::min(text.find(','), text.size());
+        const auto item = std::string(text.substr(0, end));
+        const auto x = item.find('x');
+        if (x != std::string::npos) {
+            extents.emplace_back(ParseU32(item.substr(0, x)), ParseU32(item.substr(x + 1)));
+        }
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+    return extents;
+}
+
+static auto GetLayoutName(TextureLayout layout) -> const char* {
+    switch (layout) {
+        case TextureLayout::Linear: return "linear";
+        case TextureLayout::Tiled: return "tiled";
+    }
+    return "unknown";
+}
+
+// Returns the median time in milliseconds.
+template <typename Fn>
+static auto Measure(glm::u32 iterations, Fn&& fn) -> double {
+    auto times = std::vector<double>{};
+    for (glm::u32 i = 0; i < iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn(i);
+        const auto end = std::chrono::steady_clock::now();
+        times.emplace_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + static_cast<std::ptrdiff_t>(times.size() / 2), times.end());
+    return times[times.size() / 2];
+}
+
+static void Run(const glm::uvec2& extent, TextureLayout layout, glm::u32 iterations, bool first) {
+    auto src = TextureData::Create(extent.x, extent.y, layout);
+    auto dst = TextureData::Create(extent.x, extent.y, layout);
+    auto staging = std::vector<glm::u8vec4>(static_cast<size_t>(extent.x) * extent.y);
+    auto checksum = glm::u32{};
+
+    // Writes every pixel in the order the layout stores them.
+    const auto fill = Measure(iterations, [&](glm::u32 i) {
+        src.forEachPixel([i](glm::u32 x, glm::u32 y, glm::u8vec4& pixel) {
+            pixel = glm::u8vec4(x + i, y, x ^ y, 255);
+        });
+    });
+
+    // Writes 8x8 screen blocks one after another, the pattern of a tile-based renderer.
+    const auto blockFill = Measure(iterations, [&](glm::u32 i) {
+        for (glm::u32 by = 0; by < extent.y; by += 8) {
+            for (glm::u32 bx = 0; bx < extent.x; bx += 8) {
+                for (glm::u32 y = by; y < std::min(by + 8, extent.y); ++y) {
+                    for (glm::u32 x = bx; x < std::min(bx + 8, extent.x); ++x) {
+                        src.setPixel(x, y, glm::u8vec4(x + i, y, x ^ y, 255));
+                    }
+                }
+            }
+        }
+    });
+
+    const auto blur = Measure(iterations, [&](glm::u32) {
+        dst.forEachPixel([&](glm::u32 x, glm::u32 y, glm::u8vec4& pixel) {
+            const auto x0 = x > 0 ? x - 1 : x;
+            const auto y0 = y > 0 ? y - 1 : y;
+            const auto x1 = std::min(x + 1, extent.x - 1);
+            const auto y1 = std::min(y + 1, extent.y - 1);
+
+            auto sum = glm::uvec4(0);
+            for (const auto sy : {y0, y, y1}) {
+                for (const auto sx : {x0, x, x1}) {
+                    sum += glm::uvec4(src.getPixel(sx, sy));
+                }
+            }
+            pixel = glm::u8vec4(sum / 9u);
+        });
+    });
+
+    auto hdr = HDRTextureData::Create(extent.x, extent.y, layout);
+    auto half = HalfTextureData::Create(extent.x, extent.y, layout);
+    hdr.forEachPixel([](glm::u32 x, glm::u32 y, glm::vec4& pixel) {
+        pixel = glm::vec4(glm::f32(x) / 256.0f, glm::f32(y) / 256.0f, 0.5f, 1.0f);
+    });
+
+    const auto convert = Measure(iterations, [&](glm::u32) {
+        ConvertTextureData(hdr, dst);
+    });
+    const auto convertToneMapped = Measure(iterations, [&](glm::u32) {
+        ConvertTextureData(hdr, dst, TextureConversion{.toneMapping = ToneMapping::Reinhard, .sRGB = true});
+    });
+    const auto convertHalf = Measure(iterations, [&](glm::u32) {
+        ConvertTextureData(hdr, half);
+    });
+
+    const auto upload = Measure(iterations, [&](glm::u32) {
+        dst.copyPixels(staging);
+        checksum += staging[staging.size() / 2].x;
+    });
+
+    auto blocks = std::vector<std::byte>(GetCompressedSize(extent, BlockFormat::BC7));
+    const auto encodeBC1 = Measure(iterations, [&](glm::u32) {
+        CompressPixels(staging, extent, BlockFormat::BC1, std::span(blocks.data(), GetCompressedSize(extent, BlockFormat::BC1)));
+    });
+    const auto encodeBC7 = Measure(iterations, [&](glm::u32) {
+        CompressPixels(staging, extent, BlockFormat::BC7, blocks);
+    });
+
+    const auto bytes = static_cast<double>(staging.size() * sizeof(glm::u8vec4));
+    std::printf(
+        "%s    {\"width\": %u, \"height\": %u, \"layout\": \"%s\", \"fill_ms\": %.3f, \"block_fill_ms\": %.3f, "
+        "\"blur_ms\": %.3f, \"convert_rgba8_ms\": %.3f, \"convert_srgb_reinhard_ms\": %.3f, \"convert_half_ms\": %.3f, "
+        "\"upload_ms\": %.3f, \"upload_gb_per_s\": %.3f, \"encode_bc1_ms\": %.3f, \"encode_bc7_ms\": %.3f, \"checksum\": %u}",
+        first ? "" : ",\n",
+        extent.x,
+        extent.y,
+        GetLayoutName(layout),
+        fill,
+        blockFill,
+        blur,
+        convert,
+        convertToneMapped,
+        convertHalf,
+        upload,
+        bytes / (upload * 1e6),
+        encodeBC1,
+        encodeBC7,
+        checksum
+    );
+    std::fflush(stdout);
+}
+
+auto main(int argc, char** argv) -> int {
+    auto iterations = glm::u32{20};
+    auto extents = std::vector<glm::uvec2>{{800, 600}, {1920, 1080}, {4096, 4096}};
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const auto name = std::string_view(argv[i]);
+        const auto value = std::string_view(argv[i + 1]);
+
+        if (name == "--iterations") {
+            iterations = std::max(ParseU32(std::string(value)), 1u);
+        } else if (name == "--resolutions") {
+            extents = ParseExtents(value);
+        } else {
+            std::fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::printf("{\n  \"iterations\": %u,\n  \"results\": [\n", iterations);
+
+    auto first = true;
+    for (const auto& extent : extents) {
+        if (extent.x == 0 || extent.y == 0) {
+            continue;
+        }
+        for (const auto layout : {TextureLayout::Linear, TextureLayout::Tiled}) {
+            Run(extent, layout, iterations, first);
+            first = false;
+        }
+    }
+
+    std::printf("\n  ]\n}\n");
+    return EXIT_SUCCESS;
+}
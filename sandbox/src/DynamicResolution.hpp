@@ -0,0 +1,86 @@
+#pragma once
+
+#include <TextureData.hpp>
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// Picks the internal render resolution from the measured fill time. Shading cost is proportional
+// to the pixel count, so the scale moves by sqrt(target / measured) and is smoothed and quantized
+// to avoid reallocating the render target on every frame.
+struct DynamicResolution {
+    static constexpr auto kScaleSteps = 32.0f;
+
+    bool enabled = true;
+    glm::f32 targetFrameTime = 1.0f / 60.0f;
+    glm::f32 minScale = 0.25f;
+    glm::f32 maxScale = 1.0f;
+
+    [[nodiscard]] auto getScale() const -> glm::f32 {
+        return enabled ? glm::round(_scale * kScaleSteps) / kScaleSteps : 1.0f;
+    }
+
+    [[nodiscard]] auto getExtent(const glm::uvec2& extent) const -> glm::uvec2 {
+        const auto scaled = glm::round(glm::vec2(extent) * getScale());
+        return glm::max(glm::uvec2(scaled), glm::uvec2(1));
+    }
+
+    void update(glm::f32 fillTime) {
+        if (!enabled || fillTime <= 0.0f) {
+            return;
+        }
+        const auto desired = glm::clamp(_scale * glm::sqrt(targetFrameTime / fillTime), minScale, maxScale);
+        _scale = glm::clamp(_scale + (desired - _scale) * 0.25f, minScale, maxScale);
+    }
+
+private:
+    glm::f32 _scale = 1.0f;
+};
+
+// Bilinear upscale in 8.8 fixed point. The per-column taps are computed once per call so the
+// inner loop is plain integer arithmetic that the compiler can vectorize.
+inline void UpscaleBilinear(const TextureData& src, TextureData& dst) {
+    assert(src.getLayout() == TextureLayout::Linear);
+
+    const auto srcExtent = glm::uvec2(src.getDimension());
+    const auto dstExtent = glm::uvec2(dst.getDimension());
+
+    const auto getTaps = [](glm::u32 srcSize, glm::u32 dstSize) {
+        struct Tap {
+            glm::u32 i0;
+            glm::u32 i1;
+            glm::u32 w;
+        };
+
+        auto taps = std::vector<Tap>(dstSize);
+        const auto ratio = glm::f32(srcSize) / glm::f32(dstSize);
+        for (glm::u32 i = 0; i < dstSize; ++i) {
+            const auto f = glm::clamp((glm::f32(i) + 0.5f) * ratio - 0.5f, 0.0f, glm::f32(srcSize - 1));
+            const auto i0 = static_cast<glm::u32>(f);
+            taps[i] = {
+                .i0 = i0,
+                .i1 = glm::min(i0 + 1, srcSize - 1),
+                .w = static_cast<glm::u32>((f - glm::f32(i0)) * 256.0f)
+            };
+        }
+        return taps;
+    };
+
+    const auto xs = getTaps(srcExtent.x, dstExtent.x);
+    const auto ys = getTaps(srcExtent.y, dstExtent.y);
+    const auto pixels = src.getPixels();
+
+    for (glm::u32 y = 0; y < dstExtent.y; ++y) {
+        const auto row0 = pixels.subspan(static_cast<size_t>(ys[y].i0) * srcExtent.x, srcExtent.x);
+        const auto row1 = pixels.subspan(static_cast<size_t>(ys[y].i1) * srcExtent.x, srcExtent.x);
+        const auto wy = ys[y].w;
+
+        for (glm::u32 x = 0; x < dstExtent.x; ++x) {
+            const auto [x0, x1, wx] = xs[x];
+
+            const auto top = glm::uvec4(row0[x0]) * (256 - wx) + glm::uvec4(row0[x1]) * wx;
+            const auto bottom = glm::uvec4(row1[x0]) * (256 - wx) + glm::uvec4(row1[x1]) * wx;
+            dst.setPixel(x, y, glm::u8vec4((top * (256 - wy) + bottom * wy) >> 16u));
+        }
+    }
+}
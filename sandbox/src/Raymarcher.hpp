@@ -0,0 +1,387 @@
+#pragma once
+
+#include <TextureData.hpp>
+#include <ThreadPool.hpp>
+
+#include <limits>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+static auto sdSmoothUnion(glm::f32 d1, glm::f32 d2, glm::f32 k) -> glm::f32 {
+    const auto h = glm::clamp(0.5f + 0.5f * (d2 - d1) / k, 0.0f, 1.0f);
+    return glm::mix(d2, d1, h) - k * h * (1.0f - h);
+}
+
+static auto sdSphere(const glm::vec3& c, const glm::vec3& p, glm::f32 r) -> glm::f32 {
+    return glm::length(c - p) - r;
+}
+
+static auto sdTorus(const glm::vec3& p, const glm::vec2& t) -> glm::f32 {
+    const auto q = glm::vec2(glm::length(glm::vec2(p.x, p.z)) - t.x, p.y);
+    return glm::length(q) - t.y;
+}
+
+static auto camera(const glm::vec3& cameraPos, const glm::vec3& lookAtPoint) -> glm::mat3 {
+    const auto cd = glm::normalize(lookAtPoint - cameraPos);
+    const auto cr = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), cd));
+    const auto cu = glm::normalize(glm::cross(cd, cr));
+    return glm::mat3(-cr, cu, -cd);
+}
+
+struct Raymarcher {
+    static constexpr auto kMaxDistance = 1000.0f;
+
+    // Work done by the last render: rays are the pixels that were marched (reused pixels are not
+    // counted) and iterations the scene evaluations spent on them.
+    struct Statistics {
+        glm::u64 rays = 0;
+        glm::u64 iterations = 0;
+    };
+
+    glm::f32 time{};
+    glm::vec2 resolution{};
+    glm::vec3 lightPosition{};
+    glm::vec3 cameraPosition{};
+    glm::mat3 cameraRotation{1.0f};
+
+    bool multithreading = true;
+    // Worker count used when multithreading, 0 uses the hardware concurrency.
+    glm::u32 threadCount = 0;
+
+    // Reprojection keeps the previous frame's hit distances and colors, scatters them into the
+    // current view and only re-marches pixels that are disoccluded, too old, or scheduled by the
+    // interleave pattern. Reprojected hits seed the start of the re-marched rays.
+    //
+    // Colors are only reused while the scene and the light stay as they were. A moved light
+    // re-shades the reused hits, a changed scene (time) re-marches every pixel from its seed.
+    // Changes the raymarcher cannot see, such as a new material, call invalidate().
+    // The interleave pattern spreads the refresh of reused pixels evenly over that many frames,
+    // maxAge is the backstop for pixels it misses. Ages are stored in a byte next to the
+    // disocclusion marker, so anything above 254 counts as 254.
+    bool reprojection = true;
+    glm::u32 interleave = 16;
+    glm::u32 maxAge = 64;
+    glm::f32 seedMargin = 0.25f;
+
+    // Size of the pixel blocks for the cone-marching pre-pass, 0 disables it.
+    glm::u32 coneBlockSize = 8;
+
+    [[nodiscard]] auto scene(const glm::vec3& p) const -> glm::f32 {
+        auto d = sdTorus(p, glm::vec2(1.0f, 0.2f));
+        d = sdSmoothUnion(d, sdSphere(p, glm::vec3(0.0f, glm::sin(time), 0.0f), 0.3f), 1.0f);
+        return d;
+    }
+
+    [[nodiscard]] auto calcNormal(const glm::vec3& p) const -> glm::vec3 {
+        const auto e = glm::vec2(1.0f, -1.0f) * 0.0005f;
+        return glm::normalize(
+            glm::vec3(e.x, e.y, e.y) * scene(p + glm::vec3(e.x, e.y, e.y)) +
+            glm::vec3(e.y, e.y, e.x) * scene(p + glm::vec3(e.y, e.y, e.x)) +
+            glm::vec3(e.y, e.x, e.y) * scene(p + glm::vec3(e.y, e.x, e.y)) +
+            glm::vec3(e.x, e.x, e.x) * scene(p + glm::vec3(e.x, e.x, e.x))
+        );
+    }
+
+    [[nodiscard]] auto raymarch(const glm::vec3& ro, const glm::vec3& rd, glm::f32 t = 0.0f) const -> glm::f32 {
+        auto steps = glm::u32{};
+        return raymarch(ro, rd, t, steps);
+    }
+
+    [[nodiscard]] auto raymarch(const glm::vec3& ro, const glm::vec3& rd, glm::f32 t, glm::u32& steps) const -> glm::f32 {
+        for (steps = 0; steps < 64;) {
+            const auto p = ro + rd * t;
+            const auto d = scene(p);
+            t += d;
+            steps += 1;
+            if (d < 0.001 || t > 10000.0f) {
+                break;
+            }
+        }
+        return t;
+    }
+
+    [[nodiscard]] auto getRayDirection(const glm::vec2& fragCoord) const -> glm::vec3 {
+        const auto uv = (fragCoord - 0.5f * resolution) / resolution.y;
+        return cameraRotation * glm::normalize(glm::vec3(uv, -1.0f));
+    }
+
+    [[nodiscard]] auto shade(const glm::vec3& ro, const glm::vec3& rd, glm::f32 sd) const -> glm::vec4 {
+        if (sd > kMaxDistance) {
+            return glm::vec4(0);
+        }
+        const auto p = ro + rd * sd;
+        const auto n = calcNormal(p);
+        const auto l = glm::normalize(lightPosition - p);
+        const auto i = glm::clamp(glm::dot(n, l), 0.3f, 1.0f);
+        const auto c = glm::vec3(1.0f, 0.0f, 0.0f) * i;
+        return glm::vec4(c, 1.0f);
+    }
+
+    [[nodiscard]] auto mainImage(const glm::vec2& fragCoord) const -> glm::vec4 {
+        const auto rd = getRayDirection(fragCoord);
+        return shade(cameraPosition, rd, raymarch(cameraPosition, rd));
+    }
+
+    // Drops the history, the next render marches every pixel from scratch.
+    void invalidate() {
+        _frame = 0;
+    }
+
+    [[nodiscard]] auto getStatistics() const -> Statistics {
+        auto statistics = Statistics{};
+        for (const auto& row : _rowStatistics) {
+            statistics.rays += row.rays;
+            statistics.iterations += row.iterations;
+        }
+        return statistics;
+    }
+
+    void render(TextureData& target) {
+        const auto extent = glm::uvec2(target.getDimension());
+
+        _rowStatistics.assign(extent.y, Statistics{});
+        _conePrepass(extent);
+
+        if (!reprojection) {
+            _frame = 0;
+            _history = {};
+            _forEachRow(extent.y, [&](glm::u32 y) {
+                auto& statistics = _rowStatistics[y];
+                for (glm::u32 x = 0; x < extent.x; ++x) {
+                    const auto rd = getRayDirection(glm::vec2(x, y));
+                    const auto sd = _trace(cameraPosition, rd, _getConeDistance(x, y), statistics);
+                    target.setPixel(x, y, shade(cameraPosition, rd, sd));
+                }
+            });
+            return;
+        }
+
+        if (_history.extent != extent) {
+            _history = History::Create(extent);
+            _frame = 0;
+        }
+
+        if (_frame == 0) {
+            _history.clear();
+        } else {
+            _reproject(target);
+        }
+
+        const auto sceneChanged = _history.time != time;
+        const auto lightChanged = _history.lightPosition != lightPosition;
+
+        const auto slot = interleave > 1 ? _frame % interleave : 0;
+        _forEachRow(extent.y, [&](glm::u32 y) {
+            auto& statistics = _rowStatistics[y];
+            for (glm::u32 x = 0; x < extent.x; ++x) {
+                const auto i = static_cast<size_t>(y) * extent.x + x;
+
+                const auto age = _history.nextAge[i];
+                const auto scheduled = interleave > 1 && (x + y) % interleave == slot;
+                if (age != History::kDisoccluded && age < glm::min(maxAge, History::kMaxAge) && !scheduled && !sceneChanged) {
+                    if (lightChanged) {
+                        target.setPixel(x, y, shade(cameraPosition, getRayDirection(glm::vec2(x, y)), _history.nextDepth[i]));
+                    } else {
+                        target.setPixel(x, y, _history.nextColor[i]);
+                    }
+                    _history.depth[i] = _history.nextDepth[i];
+                    _history.age[i] = static_cast<glm::u8>(age + 1);
+                    continue;
+                }
+
+                const auto rd = getRayDirection(glm::vec2(x, y));
+                const auto seed = _getSeedDistance(cameraPosition, rd, _history.nextDepth[i], _getConeDistance(x, y));
+                const auto sd = _trace(cameraPosition, rd, seed, statistics);
+
+                target.setPixel(x, y, shade(cameraPosition, rd, sd));
+                _history.depth[i] = sd;
+                _history.age[i] = 0;
+            }
+        });
+
+        _history.time = time;
+        _history.lightPosition = lightPosition;
+        _history.cameraPosition = cameraPosition;
+        _history.cameraRotation = cameraRotation;
+        _frame += 1;
+    }
+
+private:
+    struct History {
+        static constexpr auto kDisoccluded = glm::u8(0xFF);
+        static constexpr auto kMaxAge = glm::u32(kDisoccluded - 1);
+
+        glm::uvec2 extent{};
+        glm::f32 time{};
+        glm::vec3 lightPosition{};
+        glm::vec3 cameraPosition{};
+        glm::mat3 cameraRotation{1.0f};
+
+        std::unique_ptr<glm::f32[]> depth;
+        std::unique_ptr<glm::u8[]> age;
+
+        std::unique_ptr<glm::f32[]> nextDepth;
+        std::unique_ptr<glm::u8[]> nextAge;
+        std::unique_ptr<glm::u8vec4[]> nextColor;
+
+        static auto Create(const glm::uvec2& extent) -> History {
+            const auto count = static_cast<size_t>(extent.x) * extent.y;
+
+            History history;
+            history.extent = extent;
+            history.depth = std::make_unique<glm::f32[]>(count);
+            history.age = std::make_unique<glm::u8[]>(count);
+            history.nextDepth = std::make_unique<glm::f32[]>(count);
+            history.nextAge = std::make_unique<glm::u8[]>(count);
+            history.nextColor = std::make_unique<glm::u8vec4[]>(count);
+            return history;
+        }
+
+        void clear() {
+            const auto count = static_cast<size_t>(extent.x) * extent.y;
+            std::fill_n(nextDepth.get(), count, std::numeric_limits<glm::f32>::max());
+            std::fill_n(nextAge.get(), count, kDisoccluded);
+        }
+    };
+
+    // Forward-scatters last frame's samples into the current view with a nearest-depth test.
+    // Misses are reprojected as directions so that the background survives camera rotation.
+    void _reproject(const TextureData& target) {
+        _history.clear();
+
+        const auto extent = _history.extent;
+        const auto view = glm::transpose(cameraRotation);
+
+        const auto scatter = [&](const glm::vec3& local, glm::f32 distance, size_t src) {
+            if (local.z >= 0.0f) {
+                return;
+            }
+            const auto uv = glm::vec2(local.x, local.y) / -local.z;
+            const auto fragCoord = glm::round(uv * resolution.y + 0.5f * resolution);
+            if (fragCoord.x < 0.0f || fragCoord.y < 0.0f || fragCoord.x >= resolution.x || fragCoord.y >= resolution.y) {
+                return;
+            }
+
+            const auto dst = static_cast<size_t>(fragCoord.y) * extent.x + static_cast<size_t>(fragCoord.x);
+            if (_history.nextAge[dst] != History::kDisoccluded && distance >= _history.nextDepth[dst]) {
+                return;
+            }
+            _history.nextDepth[dst] = distance;
+            _history.nextAge[dst] = _history.age[src];
+            _history.nextColor[dst] = target.getPixel(
+                static_cast<glm::u32>(src % extent.x),
+                static_cast<glm::u32>(src / extent.x)
+            );
+        };
+
+        for (glm::u32 y = 0; y < extent.y; ++y) {
+            for (glm::u32 x = 0; x < extent.x; ++x) {
+                const auto i = static_cast<size_t>(y) * extent.x + x;
+                const auto depth = _history.depth[i];
+
+                const auto uv = (glm::vec2(x, y) - 0.5f * resolution) / resolution.y;
+                const auto rd = _history.cameraRotation * glm::normalize(glm::vec3(uv, -1.0f));
+
+                if (depth > kMaxDistance) {
+                    scatter(view * rd, depth, i);
+                } else {
+                    const auto p = _history.cameraPosition + rd * depth - cameraPosition;
+                    scatter(view * p, glm::length(p), i);
+                }
+            }
+        }
+    }
+
+    // The seed backs off by seedMargin to absorb scene motion since the sample was taken, and
+    // falls back to the conservative cone distance if the seeded point already lies inside geometry.
+    [[nodiscard]] auto _getSeedDistance(const glm::vec3& ro, const glm::vec3& rd, glm::f32 depth, glm::f32 cone) const -> glm::f32 {
+        if (depth > kMaxDistance) {
+            return cone;
+        }
+        const auto t = glm::max(depth - seedMargin, cone);
+        return scene(ro + rd * t) > 0.0f ? t : cone;
+    }
+
+    // Marches one cone per block that encloses the rays of all pixels in the block. The step
+    // (d - t * k) / (1 + k) keeps every enclosed ray inside the empty sphere around the axis,
+    // so the final distance is a safe start for each of them.
+    void _conePrepass(const glm::uvec2& extent) {
+        if (coneBlockSize == 0) {
+            _coneDistances.clear();
+            return;
+        }
+
+        _coneBlocks = (extent + coneBlockSize - 1u) / coneBlockSize;
+        _coneDistances.resize(static_cast<size_t>(_coneBlocks.x) * _coneBlocks.y);
+
+        _forEachRow(_coneBlocks.y, [&](glm::u32 by) {
+            for (glm::u32 bx = 0; bx < _coneBlocks.x; ++bx) {
+                const auto min = glm::vec2(bx, by) * glm::f32(coneBlockSize);
+                const auto max = glm::min(min + glm::f32(coneBlockSize - 1), glm::vec2(extent - 1u));
+                const auto rd = getRayDirection(0.5f * (min + max));
+
+                const auto k = glm::max(
+                    glm::max(glm::length(getRayDirection(min) - rd), glm::length(getRayDirection(max) - rd)),
+                    glm::max(glm::length(getRayDirection(glm::vec2(min.x, max.y)) - rd), glm::length(getRayDirection(glm::vec2(max.x, min.y)) - rd))
+                );
+
+                auto t = 0.0f;
+                for (int i = 0; i < 64 && t <= kMaxDistance; ++i) {
+                    const auto d = scene(cameraPosition + rd * t);
+                    if (d <= t * k) {
+                        break;
+                    }
+                    t += (d - t * k) / (1.0f + k);
+                }
+                _coneDistances[static_cast<size_t>(by) * _coneBlocks.x + bx] = t;
+            }
+        });
+    }
+
+    [[nodiscard]] auto _getConeDistance(glm::u32 x, glm::u32 y) const -> glm::f32 {
+        if (_coneDistances.empty()) {
+            return 0.0f;
+        }
+        return _coneDistances[static_cast<size_t>(y / coneBlockSize) * _coneBlocks.x + x / coneBlockSize];
+    }
+
+    [[nodiscard]] auto _trace(const glm::vec3& ro, const glm::vec3& rd, glm::f32 t, Statistics& statistics) const -> glm::f32 {
+        if (t > kMaxDistance) {
+            return t;
+        }
+        auto steps = glm::u32{};
+        t = raymarch(ro, rd, t, steps);
+        statistics.rays += 1;
+        statistics.iterations += steps;
+        return t;
+    }
+
+    template <typename Fn>
+    void _forEachRow(glm::u32 height, Fn&& fn) {
+        if (!multithreading) {
+            for (glm::u32 y = 0; y < height; ++y) {
+                fn(y);
+            }
+            return;
+        }
+
+        auto pool = ThreadPool{threadCount != 0 ? threadCount : std::thread::hardware_concurrency()};
+        for (glm::u32 y = 0; y < height; ++y) {
+            pool.jobs.emplace([&fn, y] {
+                fn(y);
+            });
+        }
+        pool.start();
+        pool.wait();
+    }
+
+    History _history{};
+    glm::u32 _frame = 0;
+
+    glm::uvec2 _coneBlocks{};
+    std::vector<glm::f32> _coneDistances;
+
+    std::vector<Statistics> _rowStatistics;
+};
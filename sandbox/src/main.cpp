@@ -3,12 +3,20 @@
 #include <Blaze.hpp>
 #include <Screen.hpp>
 #include <Display.hpp>
+#include <Graphics.hpp>
 #include <Texture.hpp>
 #include <Material.hpp>
+#include <TextureStreamer.hpp>
 #include "TextureData.hpp"
+#include "Raymarcher.hpp"
+#include "DynamicResolution.hpp"
 #include <VulkanMaterial.hpp>
+#include <VulkanGfxDevice.hpp>
 #include <VulkanGraphicsBuffer.hpp>
+#include <VulkanFrameAllocator.hpp>
 
+#include <chrono>
+#include <cstring>
 #include <imgui.h>
 #include <physfs.h>
 #include <filesystem>
@@ -23,92 +31,22 @@ struct MaterialPropertyBlock {
     alignas(16) glm::mat4 CameraRotation;
 };
 
-float iTime;
-glm::vec2 iResolution;
-glm::vec3 iLightPosition;
-glm::vec3 iCameraPosition;
-glm::mat3 iCameraRotation;
-
-static auto sdSmoothUnion(glm::f32 d1, glm::f32 d2, glm::f32 k) -> glm::f32 {
-    const auto h = glm::clamp(0.5f + 0.5f * (d2 - d1) / k, 0.0f, 1.0f);
-    return glm::mix(d2, d1, h) - k * h * (1.0f - h);
-}
-
-static auto sdSphere(const glm::vec3& c, const glm::vec3& p, glm::f32 r) -> glm::f32 {
-    return glm::length(c - p) - r;
-}
-
-static auto sdTorus(const glm::vec3& p, const glm::vec2& t) -> glm::f32 {
-    const auto q = glm::vec2(glm::length(glm::vec2(p.x, p.z)) - t.x, p.y);
-    return glm::length(q) - t.y;
-}
-
-static auto scene(const glm::vec3& p) -> glm::f32 {
-    auto d = sdTorus(p, glm::vec2(1.0f, 0.2f));
-    d = sdSmoothUnion(d, sdSphere(p, glm::vec3(0.0f, glm::sin(iTime), 0.0f), 0.3f), 1.0f);
-    return d;
-}
-
-static auto camera(const glm::vec3& cameraPos, const glm::vec3& lookAtPoint) -> glm::mat3 {
-    const auto cd = glm::normalize(lookAtPoint - cameraPos);
-    const auto cr = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), cd));
-    const auto cu = glm::normalize(glm::cross(cd, cr));
-    return glm::mat3(-cr, cu, -cd);
-}
-
-static auto calcNormal(const glm::vec3& p) -> glm::vec3 {
-    const auto e = glm::vec2(1.0f, -1.0f) * 0.0005f;
-    return glm::normalize(
-        glm::vec3(e.x, e.y, e.y) * scene(p + glm::vec3(e.x, e.y, e.y)) +
-        glm::vec3(e.y, e.y, e.x) * scene(p + glm::vec3(e.y, e.y, e.x)) +
-        glm::vec3(e.y, e.x, e.y) * scene(p + glm::vec3(e.y, e.x, e.y)) +
-        glm::vec3(e.x, e.x, e.x) * scene(p + glm::vec3(e.x, e.x, e.x))
-    );
-}
-
-static auto raymarch(const glm::vec3& ro, const glm::vec3& rd) -> glm::f32 {
-    glm::f32 t = 0;
-    for (int i = 0; i < 64; ++i) {
-        const auto p = ro + rd * t;
-        const auto d = scene(p);
-        t += d;
-        if (d < 0.001 || t > 10000.0f) {
-            break;
-        }
-    }
-    return t;
-}
-
-static auto mainImage(const glm::vec2& fragCoord) -> glm::vec4 {
-    const auto uv = (fragCoord - 0.5f * iResolution) / iResolution.y;
-
-    const auto ro = iCameraPosition;
-    const auto rd = iCameraRotation * glm::normalize(glm::vec3(uv, -1.0f));
-
-    const auto sd = raymarch(ro, rd);
-    if (sd > 1000.0f) {
-        return glm::vec4(0);
-    }
-    const auto p = ro + rd * sd;
-    const auto n = calcNormal(p);
-    const auto l = glm::normalize(iLightPosition - p);
-    const auto i = glm::clamp(glm::dot(n, l), 0.3f, 1.0f);
-    const auto c = glm::vec3(1.0f, 0.0f, 0.0f) * i;
-    return glm::vec4(c, 1.0f);
-}
-
 struct Vertex2D {
     glm::vec2 xy{};
     glm::vec2 uv{};
     glm::u8vec4 rgba{};
 };
 
+// The geometry is rebuilt every frame, so it lives in the frame allocator.
 struct Graphics2D {
-    Mesh mesh;
     Material material;
     std::vector<glm::u32> indices;
     std::vector<Vertex2D> vertices;
 
+    VulkanFrameAllocation vertexAllocation{};
+    VulkanFrameAllocation indexAllocation{};
+    glm::u32 indexCount = 0;
+
     explicit Graphics2D() {
         material = Material::LoadFromResources("sandbox:materials/gfx.material");
     }
@@ -130,21 +68,30 @@ struct Graphics2D {
     }
 
     void Flush() {
-        mesh.setVertexBufferParams(static_cast<glm::i32>(vertices.size()), sizeof(Vertex2D));
-        mesh.setVertexBufferData(std::as_bytes(std::span(vertices)), 0);
+        extern auto GetGfxDevice() -> VulkanGfxDevice&;
+
+        indexCount = static_cast<glm::u32>(indices.size());
+        if (indexCount > 0) {
+            auto& allocator = GetGfxDevice().getFrameAllocator();
+            vertexAllocation = allocator.allocate(vertices.size() * sizeof(Vertex2D), alignof(Vertex2D));
+            indexAllocation = allocator.allocate(indices.size() * sizeof(glm::u32), sizeof(glm::u32));
 
-        mesh.setIndexBufferParams(static_cast<glm::i32>(indices.size()), sizeof(glm::u32));
-        mesh.setIndexBufferData(std::as_bytes(std::span(indices)), 0);
+            std::memcpy(vertexAllocation.data, vertices.data(), vertices.size() * sizeof(Vertex2D));
+            std::memcpy(indexAllocation.data, indices.data(), indices.size() * sizeof(glm::u32));
+        }
 
         indices.clear();
         vertices.clear();
     }
 
+    // Draws the geometry of the last Flush, which must have happened in the same frame.
     void Draw(CommandBuffer cmd) {
         extern auto GetDisplay() -> Display&;
 
-        auto vk_vertexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeVertexBufferPtr());
-        auto vk_indexBuffer = static_cast<VulkanGraphicsBuffer*>(mesh.getNativeIndexBufferPtr());
+        if (indexCount == 0) {
+            return;
+        }
+
         auto vk_material = static_cast<VulkanMaterial*>(material.GetNativeHandlePtr());
 
         const auto DisplaySize = glm::vec2(GetDisplay().getSize());
@@ -159,7 +106,7 @@ struct Graphics2D {
             vk::PipelineBindPoint::eGraphics,
             vk_material->pipelineLayout,
             0,
-            vk_material->descriptorSets,
+            vk_material->descriptorSet,
             vk_material->dynamicOffsets
         );
 
@@ -178,34 +125,50 @@ struct Graphics2D {
             transform.data()
         );
 
-        _cmd.bindVertexBuffers(0, vk_vertexBuffer->buffer, vk::DeviceSize{0});
-        _cmd.bindIndexBuffer(vk_indexBuffer->buffer, 0, vk::IndexType::eUint32);
-        _cmd.drawIndexed(mesh.getIndexCount(), 1, 0, 0, 0);
-
-//        cmd.drawMesh(mesh, material);
+        _cmd.bindVertexBuffers(0, vertexAllocation.buffer, vertexAllocation.offset);
+        _cmd.bindIndexBuffer(indexAllocation.buffer, indexAllocation.offset, vk::IndexType::eUint32);
+        _cmd.drawIndexed(indexCount, 1, 0, 0, 0);
     }
 };
 
 struct Game : Blaze::Application {
     Mesh _mesh;
     Material _material;
+    Material _blitMaterial;
     Texture2D _texture;
     TextureData _textureData = TextureData::Create(800, 600);
+    TextureData _renderData{};
+    Raymarcher _raymarcher{};
+    DynamicResolution _dynamicResolution{};
 
-    GraphicsBuffer _constantBuffer;
     std::unique_ptr<Graphics2D> gfx{};
 
-    bool _multithreading = true;
+    TextureStreamer _streamer{};
+    tl::optional<StreamedTextureId> _streamedTexture{};
+    Material _streamedMaterial;
+
+    bool _softwareRendering = false;
+    bool _showStreamedTexture = false;
 
     void Init() override {
         gfx = std::make_unique<Graphics2D>();
 
         _texture = Texture2D(800, 600, vk::Format::eR8G8B8A8Unorm);
 
-        _constantBuffer = GraphicsBuffer(GraphicsBuffer::Target::Constant, sizeof(MaterialPropertyBlock));
         _material = Material::LoadFromResources("sandbox:materials/texture.material");
         _material.SetTexture(1, _texture);
-        _material.SetConstantBuffer(0, _constantBuffer);
+        _material.SetPerDrawConstantBuffer(0);
+        _blitMaterial = Material::LoadFromResources("sandbox:materials/blit.material");
+        _blitMaterial.SetTexture(1, _texture);
+        _blitMaterial.SetPerDrawConstantBuffer(0);
+
+        // Optional, any 2D KTX2 file with a stored mip chain shows the streamer at work.
+        _streamedTexture = _streamer.add("sandbox:textures/streamed.ktx2");
+        if (_streamedTexture) {
+            _streamedMaterial = Material::LoadFromResources("sandbox:materials/blit.material");
+            _streamedMaterial.SetPerDrawConstantBuffer(0);
+            _streamer.bind(*_streamedTexture, _streamedMaterial, 1);
+        }
 
         const auto vertices = std::array {
             glm::vec4{-1, -1, 0, 1},
@@ -231,86 +194,75 @@ struct Game : Blaze::Application {
         _mesh = {};
         _texture = {};
         _material = {};
-        _constantBuffer = {};
+        _blitMaterial = {};
+        _streamedMaterial = {};
+        _streamer = TextureStreamer{};
     }
 
     void Update() override {
-        iTime += Time::getDeltaTime();
-        iResolution = glm::vec2(_textureData.getDimension());
-        iLightPosition = glm::vec3(
-            glm::sin(glm::radians(180.0f) * iTime) * 2.0f,
-            0.5f,
-            glm::cos(glm::radians(180.0f) * iTime) * 2.0f
-        );
-        iCameraPosition = glm::vec3(5, 5, 5);
-        iCameraRotation = camera(iCameraPosition, glm::vec3(0, 0, 0));
+        _streamer.update();
 
-//        if (_multithreading) {
-//            auto pool = ThreadPool{};
-//
-//            const auto xstep = extent.width;
-//            const auto ystep = 1;
-//
-//            for (glm::u32 y = 0; y < extent.height; y += ystep) {
-//                for (glm::u32 x = 0; x < extent.width; x += xstep) {
-//                    pool.jobs.emplace([this, x0 = x, x1 = x + xstep, y0 = y, y1 = y + ystep] {
-//                        FillTexture(x0, x1, y0, y1);
-//                    });
-//                }
-//
-//            }
-//            pool.start();
-//            pool.wait();
-//        } else {
-//            FillTexture(0, extent.width, 0, extent.height);
-//        }
-//        _texture.setPixels(_textureData.getPixels());
-    }
+        const auto extent = _dynamicResolution.getExtent(glm::uvec2(_textureData.getDimension()));
 
-    void FillTexture(glm::u32 x0, glm::u32 x1, glm::u32 y0, glm::u32 y1) {
-        for (glm::u32 y = y0; y < y1; ++y) {
-            for (glm::u32 x = x0; x < x1; ++x) {
-                _textureData.setPixel(x, y, mainImage(glm::vec2(x, y)));
+        _raymarcher.time += Time::getDeltaTime();
+        _raymarcher.resolution = glm::vec2(extent);
+        _raymarcher.lightPosition = glm::vec3(
+            glm::sin(glm::radians(180.0f) * _raymarcher.time) * 2.0f,
+            0.5f,
+            glm::cos(glm::radians(180.0f) * _raymarcher.time) * 2.0f
+        );
+        _raymarcher.cameraPosition = glm::vec3(5, 5, 5);
+        _raymarcher.cameraRotation = camera(_raymarcher.cameraPosition, glm::vec3(0, 0, 0));
+
+        if (_softwareRendering) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            if (extent == glm::uvec2(_textureData.getDimension())) {
+                _raymarcher.render(_textureData);
+            } else {
+                if (extent != glm::uvec2(_renderData.getDimension())) {
+                    _renderData = TextureData::Create(extent.x, extent.y);
+                }
+                _raymarcher.render(_renderData);
+                UpscaleBilinear(_renderData, _textureData);
             }
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            _dynamicResolution.update(std::chrono::duration<float, std::chrono::seconds::period>(end - start).count());
+            _texture.setPixels(_textureData);
         }
     }
 
     void Draw(CommandBuffer cmd) override {
-        auto block = MaterialPropertyBlock {
-            .Time = iTime,
-            .Resolution = iResolution,
-            .LightPosition = iLightPosition,
-            .CameraPosition = iCameraPosition,
-            .CameraRotation = iCameraRotation
-        };
-
-        auto vk_material = static_cast<VulkanMaterial*>(_material.GetNativeHandlePtr());
-        _constantBuffer.setData(&block, sizeof(MaterialPropertyBlock), 0);
-
-        auto _cmd = *cmd;
-        _cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, vk_material->pipeline);
-        _cmd.bindDescriptorSets(
-            vk::PipelineBindPoint::eGraphics,
-            vk_material->pipelineLayout,
-            0,
-            vk_material->descriptorSets,
-            vk_material->dynamicOffsets
-        );
-        _cmd.pushConstants(
-            vk_material->pipelineLayout,
-            vk::ShaderStageFlagBits::eFragment,
-            0,
-            sizeof(MaterialPropertyBlock),
-            &block
-        );
+        // The quad covers the screen, so its larger side is the size the texture is drawn at.
+        if (_showStreamedTexture) {
+            _streamer.reportUsage(*_streamedTexture, static_cast<glm::f32>(glm::max(Screen::getSize().x, Screen::getSize().y)));
+        }
 
-        auto vtx_ptr = static_cast<VulkanGraphicsBuffer*>(_mesh.getNativeVertexBufferPtr());
-        auto idx_ptr = static_cast<VulkanGraphicsBuffer*>(_mesh.getNativeIndexBufferPtr());
+        // Each frame in flight reads its own copy from the uniform ring.
+        const auto block = MaterialPropertyBlock {
+            .Time = _raymarcher.time,
+            .Resolution = _raymarcher.resolution,
+            .LightPosition = _raymarcher.lightPosition,
+            .CameraPosition = _raymarcher.cameraPosition,
+            .CameraRotation = _raymarcher.cameraRotation
+        };
+        const auto constants = Graphics::AllocatePerDrawConstants(block);
+        if (!constants) {
+            return;
+        }
 
-        _cmd.bindVertexBuffers(0, vtx_ptr->buffer, vk::DeviceSize{0});
-        _cmd.bindIndexBuffer(idx_ptr->buffer, 0, vk::IndexType::eUint32);
-        _cmd.drawIndexed(_mesh.getIndexCount(), 1, 0, 0, 0);
-//        cmd.drawMesh(_mesh, _material);
+        const auto& material = _showStreamedTexture ? _streamedMaterial : _softwareRendering ? _blitMaterial : _material;
+        if (!_showStreamedTexture && !_softwareRendering) {
+            auto vk_material = static_cast<VulkanMaterial*>(material.GetNativeHandlePtr());
+            (*cmd).pushConstants(
+                vk_material->pipelineLayout,
+                vk::ShaderStageFlagBits::eFragment,
+                0,
+                sizeof(MaterialPropertyBlock),
+                &block
+            );
+        }
+        cmd.drawMesh(_mesh, material, *constants);
 
 //        glm::f32 title = 20;
 //        glm::vec2 pos{100, 100};
@@ -329,10 +281,30 @@ struct Game : Blaze::Application {
 
     void DrawUI() override {
         ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
-        ImGui::SetNextWindowSize(ImVec2(200, 100), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImVec2(240, 240), ImGuiCond_Always);
         ImGui::Begin("Info");
         ImGui::TextUnformatted(fmt::format("DeltaTime: {:.3}s", Time::getDeltaTime()).c_str());
-//        ImGui::Checkbox("Multithreading", &_multithreading);
+        if (_streamedTexture) {
+            ImGui::Checkbox("Streamed texture", &_showStreamedTexture);
+            if (_showStreamedTexture) {
+                ImGui::TextUnformatted(fmt::format("Streamed: {} / {} KiB", _streamer.getResidentBytes() / 1024, _streamer.getBudget() / 1024).c_str());
+            }
+        }
+        ImGui::Checkbox("Software rendering", &_softwareRendering);
+        if (_softwareRendering) {
+            ImGui::Checkbox("Multithreading", &_raymarcher.multithreading);
+            ImGui::Checkbox("Dynamic resolution", &_dynamicResolution.enabled);
+            if (_dynamicResolution.enabled) {
+                ImGui::TextUnformatted(fmt::format("Render scale: {:.2}", _dynamicResolution.getScale()).c_str());
+            }
+            ImGui::Checkbox("Reprojection", &_raymarcher.reprojection);
+            if (_raymarcher.reprojection) {
+                static constexpr auto interleave = std::array{glm::u32(1), glm::u32(32)};
+                static constexpr auto maxAge = std::array{glm::u32(1), glm::u32(128)};
+                ImGui::SliderScalar("Interleave", ImGuiDataType_U32, &_raymarcher.interleave, &interleave[0], &interleave[1]);
+                ImGui::SliderScalar("Max age", ImGuiDataType_U32, &_raymarcher.maxAge, &maxAge[0], &maxAge[1]);
+            }
+        }
         ImGui::End();
     }
 };